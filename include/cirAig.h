@@ -0,0 +1 @@
+../src/cir/cirAig.h
\ No newline at end of file
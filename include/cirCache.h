@@ -0,0 +1 @@
+../src/cir/cirCache.h
\ No newline at end of file
@@ -0,0 +1 @@
+../src/cir/cirGen.h
\ No newline at end of file
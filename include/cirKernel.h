@@ -0,0 +1 @@
+../src/cir/cirKernel.h
\ No newline at end of file
@@ -0,0 +1 @@
+../src/cir/cirMgr.h
\ No newline at end of file
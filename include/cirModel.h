@@ -0,0 +1 @@
+../src/cir/cirModel.h
\ No newline at end of file
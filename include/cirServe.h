@@ -0,0 +1 @@
+../src/cir/cirServe.h
\ No newline at end of file
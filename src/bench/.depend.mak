@@ -0,0 +1,5 @@
+bench.o: bench.cpp ../../include/util.h ../../include/rnGen.h \
+ ../../include/myUsage.h ../../include/cirMgr.h ../../include/cirDef.h \
+ ../../include/cirModel.h ../../include/cirCache.h ../../include/cirAig.h \
+ ../../include/cirKernel.h ../../include/cirGen.h \
+ ../../include/cirServe.h
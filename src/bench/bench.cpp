@@ -0,0 +1,544 @@
+/****************************************************************************
+  FileName     [ bench.cpp ]
+  PackageName  [ bench ]
+  Synopsis     [ Define the benchmark harness of the cir package ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2007-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cstdio>
+#include <ctime>
+#include <thread>
+#include <unistd.h>
+#include <sys/socket.h>
+#include "util.h"
+#include "cirMgr.h"
+#include "cirKernel.h"
+#include "cirGen.h"
+#include "cirServe.h"
+
+using namespace std;
+
+//----------------------------------------------------------------------
+//    Benchmark records
+//----------------------------------------------------------------------
+struct BenchStat
+{
+   string          _name;     // benchmark case
+   string          _data;     // dataset label
+   string          _unit;     // unit of throughput
+   double          _work;     // work done in one repetition, in _unit
+   vector<double>  _times;    // seconds of each repetition
+
+   double median() const { return percentile(0.5); }
+   double p95() const { return percentile(0.95); }
+   double throughput() const {
+      double m = median(); return m > 0 ? _work / m : 0.0;
+   }
+   // nearest-rank percentile
+   double percentile(double p) const {
+      if (_times.empty()) return 0.0;
+      vector<double> t(_times);
+      sort(t.begin(), t.end());
+      size_t rank = size_t(p * t.size() + 0.999999);
+      return t[rank ? rank - 1 : 0];
+   }
+};
+
+static vector<BenchStat> stats;
+static int               reps = 5;
+static volatile double   sink = 0;  // keeps the kernels from being removed
+
+static void
+usage()
+{
+   cout << "Usage: cirBench [-File <ratings.csv>]... [-Scale (int n)] "
+        << "[-Reps (int n)]" << endl
+        << "                [-Synth (int users) (int movies) (double density)]..."
+        << endl
+        << "                [-Circuit <aagFile | aigFile>]..." << endl
+        << "                [-Csv <file>] [-Json <file>] [-Label <string>]"
+        << endl
+        << "       cirBench -Load <port | socket> [-Clients (int n)] "
+        << "[-Requests (int n)] [-K (int k)]" << endl;
+}
+
+static void
+myexit()
+{
+   usage();
+   exit(-1);
+}
+
+static BenchStat&
+newStat(const string& name, const string& data, const string& unit,
+        double work)
+{
+   stats.push_back(BenchStat());
+   BenchStat& s = stats.back();
+   s._name = name; s._data = data; s._unit = unit; s._work = work;
+   return s;
+}
+
+static void
+printStat(const BenchStat& s)
+{
+   cout << setw(12) << left << s._name << setw(20) << left << s._data
+        << " median " << setw(10) << left << s.median()
+        << " p95 " << setw(10) << left << s.p95()
+        << " " << s.throughput() << " " << s._unit << endl;
+}
+
+//----------------------------------------------------------------------
+//    Synthetic scale-up: "n" copies of "src" with disjoint user ids
+//----------------------------------------------------------------------
+static string
+scaleFile(const string& src, int n)
+{
+   ifstream in(src.c_str());
+   if (!in) { cerr << "Error: cannot open \"" << src << "\"!!" << endl; return ""; }
+   vector<string> lines;
+   int maxUser = 0;
+   string line;
+   while (getline(in, line)) {
+      int user;
+      if (!myStr2Int(line.substr(0, line.find(',')), user)) continue;
+      maxUser = user > maxUser ? user : maxUser;
+      lines.push_back(line);
+   }
+   char tmpName[] = "/tmp/cirBench.XXXXXX";
+   int fd = mkstemp(tmpName);
+   if (fd < 0) { cerr << "Error: cannot create temp file!!" << endl; return ""; }
+   close(fd);
+   ofstream out(tmpName);
+   for (int c = 0; c < n; ++c) {
+      for (size_t i = 0; i < lines.size(); ++i) {
+         size_t comma = lines[i].find(',');
+         int user;
+         myStr2Int(lines[i].substr(0, comma), user);
+         out << user + c * (maxUser + 1) << lines[i].substr(comma) << '\n';
+      }
+   }
+   return tmpName;
+}
+
+// A MATB snapshot from MatGenerator with the default model and seed
+static string
+synthFile(const MatGenerator& gen)
+{
+   char tmpName[] = "/tmp/cirBench.XXXXXX";
+   int fd = mkstemp(tmpName);
+   if (fd < 0) { cerr << "Error: cannot create temp file!!" << endl; return ""; }
+   close(fd);
+   MatGenerator g(gen);
+   g._binary = true;
+   if (!g.generate(tmpName)) { unlink(tmpName); return ""; }
+   return tmpName;
+}
+
+//----------------------------------------------------------------------
+//    Benchmark cases
+//----------------------------------------------------------------------
+static CirMgr*
+benchParse(const string& file, const string& data)
+{
+   CirMgr* mgr = 0;
+   BenchStat* s = 0;
+   for (int r = 0; r < reps; ++r) {
+      delete mgr;
+      mgr = new CirMgr;
+      double t = myUsage.getWallTime();
+      if (!mgr->readMatrix(file)) { delete mgr; return 0; }
+      t = myUsage.getWallTime() - t;
+      if (s == 0) s = &newStat("parse", data, "ratings/s", mgr->getRatings());
+      s->_times.push_back(t);
+   }
+   printStat(*s);
+   return mgr;
+}
+
+static void
+benchTrain(CirMgr* mgr, const string& data)
+{
+   mgr->initTraining();
+   BenchStat& s = newStat("train_epoch", data, "ratings/s", mgr->getRatings());
+   for (int r = 0; r < reps; ++r) {
+      double t = myUsage.getWallTime();
+      mgr->trainEpoch(r + 1);
+      s._times.push_back(myUsage.getWallTime() - t);
+   }
+   printStat(s);
+   mgr->publishModel();
+}
+
+static void
+benchKernels(int n)
+{
+   const int calls = 1000000;
+   vector<double> x(n), y(n);
+   for (int k = 0; k < n; ++k) {
+      x[k] = (rnGen(2000) - 1000) * 0.0001;
+      y[k] = (rnGen(2000) - 1000) * 0.0001;
+   }
+   ostringstream data;
+   data << "latent=" << n;
+
+   BenchStat& d = newStat("dot", data.str(), "GFLOP/s", 2e-9 * n * calls);
+   for (int r = 0; r < reps; ++r) {
+      double t = myUsage.getWallTime(), sum = 0;
+      for (int c = 0; c < calls; ++c) {
+         sum += matDot(&x[0], &y[0], n);
+         x[c % n] += 1e-12;    // defeat loop-invariant hoisting
+      }
+      d._times.push_back(myUsage.getWallTime() - t);
+      sink = sink + sum;
+   }
+   printStat(d);
+
+   BenchStat& a = newStat("axpy", data.str(), "GFLOP/s", 2e-9 * n * calls);
+   for (int r = 0; r < reps; ++r) {
+      double t = myUsage.getWallTime();
+      for (int c = 0; c < calls; ++c)
+         matAxpy((c & 1) ? 1e-9 : -1e-9, &x[0], &y[0], n);
+      a._times.push_back(myUsage.getWallTime() - t);
+      sink = sink + y[0];
+   }
+   printStat(a);
+}
+
+static bool
+sameMovie(const MovieScore& a, const MovieScore& b)
+{
+   return a._movie == b._movie;
+}
+
+static void
+benchQueries(CirMgr* mgr, const string& data)
+{
+   const int predicts = 1000000, queries = 200;
+   int users = mgr->getMaxUserId() + 1, movies = mgr->getMaxMovieId() + 1;
+
+   BenchStat& p = newStat("predict", data, "predictions/s", predicts);
+   for (int r = 0; r < reps; ++r) {
+      double t = myUsage.getWallTime(), sum = 0, score = 0;
+      for (int c = 0; c < predicts; ++c)
+         if (mgr->predict(rnGen(users), rnGen(movies), score)) sum += score;
+      p._times.push_back(myUsage.getWallTime() - t);
+      sink = sink + sum;
+   }
+   printStat(p);
+
+   // the full scan, then hot users answered from the cache
+   ScoreList result;
+   size_t cache = mgr->getCacheSize();
+   mgr->setCacheSize(0);
+   BenchStat& q = newStat("recommend", data, "queries/s", queries);
+   for (int r = 0; r < reps; ++r) {
+      double t = myUsage.getWallTime();
+      for (int c = 0; c < queries; ++c)
+         mgr->recommend(rnGen(users), 10, result);
+      q._times.push_back(myUsage.getWallTime() - t);
+   }
+   printStat(q);
+
+   // the same users from the int8 table; the results must not change
+   vector<unsigned> users0(queries);
+   vector<ScoreList> exact(queries);
+   for (int c = 0; c < queries; ++c) {
+      users0[c] = rnGen(users);
+      mgr->recommend(users0[c], 10, exact[c]);
+   }
+   mgr->setQuantize(true);
+   mgr->publishModel();
+   BenchStat& i8 = newStat("rec_int8", data, "queries/s", queries);
+   int same = 0;
+   for (int r = 0; r < reps; ++r) {
+      double t = myUsage.getWallTime();
+      for (int c = 0; c < queries; ++c)
+         mgr->recommend(users0[c], 10, result);
+      i8._times.push_back(myUsage.getWallTime() - t);
+   }
+   for (int c = 0; c < queries; ++c) {
+      mgr->recommend(users0[c], 10, result);
+      same += (result.size() == exact[c].size() &&
+               equal(result.begin(), result.end(), exact[c].begin(),
+                     sameMovie));
+   }
+   printStat(i8);
+   if (same != queries)
+      cerr << "Error: " << queries - same << " int8 results differ!!" << endl;
+   mgr->setQuantize(false);
+   mgr->publishModel();
+
+   mgr->setCacheSize(cache);
+   const int hot = 16, hits = 100000;
+   BenchStat& h = newStat("rec_cached", data, "queries/s", hits);
+   for (int r = 0; r < reps; ++r) {
+      double t = myUsage.getWallTime();
+      for (int c = 0; c < hits; ++c)
+         mgr->recommend(rnGen(hot < users ? hot : users), 10, result);
+      h._times.push_back(myUsage.getWallTime() - t);
+   }
+   printStat(h);
+}
+
+static void
+benchDataset(const string& file, const string& data)
+{
+   CirMgr* mgr = benchParse(file, data);
+   if (mgr == 0) return;
+   benchTrain(mgr, data);
+   benchQueries(mgr, data);
+   delete mgr;
+}
+
+// Reading and random simulation of an AIGER circuit
+static void
+benchCircuit(const string& file)
+{
+   CirMgr* mgr = 0;
+   BenchStat* s = 0;
+   for (int r = 0; r < reps; ++r) {
+      delete mgr;
+      mgr = new CirMgr;
+      double t = myUsage.getWallTime();
+      if (!mgr->readCircuit(file)) { delete mgr; return; }
+      t = myUsage.getWallTime() - t;
+      if (s == 0)
+         s = &newStat("cir_read", file, "gates/s", mgr->getNetList().size());
+      s->_times.push_back(t);
+   }
+   printStat(*s);
+
+   const unsigned passes = 16;
+   BenchStat& m = newStat("cir_sim", file, "Geval/s",
+                          1e-9 * mgr->getNetList().size() * passes *
+                          CIR_SIM_WORDS * 64);
+   for (int r = 0; r < reps; ++r) {
+      double t = myUsage.getWallTime();
+      mgr->randomSim(passes);
+      m._times.push_back(myUsage.getWallTime() - t);
+   }
+   printStat(m);
+   delete mgr;
+}
+
+//----------------------------------------------------------------------
+//    Load generator for "cirTest -Serve" (see cirServe.h)
+//----------------------------------------------------------------------
+// One response line into "line"; false if the server is gone
+static bool
+recvLine(int fd, string& buf, string& line)
+{
+   char tmp[4096];
+   size_t nl;
+   while ((nl = buf.find('\n')) == string::npos) {
+      ssize_t n = recv(fd, tmp, sizeof(tmp), 0);
+      if (n <= 0) return false;
+      buf.append(tmp, n);
+   }
+   line = buf.substr(0, nl);
+   buf.erase(0, nl + 1);
+   return true;
+}
+
+// "requests" closed-loop requests per client: recommendations of "k"
+// movies, or predictions if "k" is 0
+static void
+loadClient(const string& addr, int requests, int k, int users, int movies,
+           MatLatency* lat, int* errors)
+{
+   int fd = matConnect(addr);
+   if (fd < 0) { *errors = requests; return; }
+   string buf, line;
+   char req[64];
+   for (int c = 0; c < requests; ++c) {
+      int len = k ? sprintf(req, "R %d %d\n", rnGen(users), k)
+                  : sprintf(req, "P %d %d\n", rnGen(users), rnGen(movies));
+      double t = myUsage.getWallTime();
+      if (send(fd, req, len, MSG_NOSIGNAL) != len ||
+          !recvLine(fd, buf, line)) {
+         *errors += requests - c;
+         break;
+      }
+      lat->add((myUsage.getWallTime() - t) * 1e6);
+      if (line.compare(0, 2, "OK") != 0) ++*errors;
+   }
+   close(fd);
+}
+
+static bool
+benchLoad(const string& addr, int clients, int requests, int k)
+{
+   int fd = matConnect(addr);
+   string buf, line;
+   int users = 0, movies = 0;
+   if (fd < 0 || send(fd, "I\n", 2, MSG_NOSIGNAL) != 2 ||
+       !recvLine(fd, buf, line) ||
+       sscanf(line.c_str(), "OK %d %d", &users, &movies) != 2) {
+      cerr << "Error: cannot query the server at \"" << addr << "\"!!"
+           << endl;
+      if (fd >= 0) close(fd);
+      return false;
+   }
+   close(fd);
+
+   ostringstream data;
+   data << addr << "x" << clients;
+   BenchStat& s = newStat(k ? "serve_recommend" : "serve_predict",
+                          data.str(), "requests/s", double(clients) * requests);
+   MatLatency lat;
+   vector<int> errors(clients, 0);
+   vector<thread> threads;
+   double t = myUsage.getWallTime();
+   for (int i = 0; i < clients; ++i)
+      threads.push_back(thread(loadClient, addr, requests, k, users + 1,
+                               movies + 1, &lat, &errors[i]));
+   for (int i = 0; i < clients; ++i) threads[i].join();
+   s._times.push_back(myUsage.getWallTime() - t);
+   printStat(s);
+
+   int errs = 0;
+   for (int i = 0; i < clients; ++i) errs += errors[i];
+   cout << "latency p50 " << lat.percentile(0.5) << " us, p99 "
+        << lat.percentile(0.99) << " us, errors " << errs << endl;
+   return true;
+}
+
+//----------------------------------------------------------------------
+//    Reports
+//----------------------------------------------------------------------
+static bool
+writeCsv(const string& file, const string& label, time_t now)
+{
+   ofstream out(file.c_str());
+   if (!out) return false;
+   out << "label,time,name,data,reps,median_s,p95_s,throughput,unit\n";
+   for (size_t i = 0; i < stats.size(); ++i) {
+      const BenchStat& s = stats[i];
+      out << label << ',' << now << ',' << s._name << ',' << s._data << ','
+          << s._times.size() << ',' << s.median() << ',' << s.p95() << ','
+          << s.throughput() << ',' << s._unit << '\n';
+   }
+   return true;
+}
+
+static bool
+writeJson(const string& file, const string& label, time_t now)
+{
+   ofstream out(file.c_str());
+   if (!out) return false;
+   out << "[\n";
+   for (size_t i = 0; i < stats.size(); ++i) {
+      const BenchStat& s = stats[i];
+      out << "  {\"label\": \"" << label << "\", \"time\": " << now
+          << ", \"name\": \"" << s._name << "\", \"data\": \"" << s._data
+          << "\", \"reps\": " << s._times.size()
+          << ", \"median_s\": " << s.median() << ", \"p95_s\": " << s.p95()
+          << ", \"throughput\": " << s.throughput()
+          << ", \"unit\": \"" << s._unit << "\"}"
+          << (i + 1 < stats.size() ? ",\n" : "\n");
+   }
+   out << "]\n";
+   return true;
+}
+
+int
+main(int argc, char** argv)
+{
+   vector<string> files, circuits;
+   vector<MatGenerator> synths;
+   string csvFile, jsonFile, label, loadAddr;
+   int scale = 0, clients = 4, requests = 10000, k = 10;
+   for (int i = 1; i < argc; ++i) {
+      bool hasArg = (i + 1 < argc);
+      if (myStrNCmp("-File", argv[i], 2) == 0 && hasArg)
+         files.push_back(argv[++i]);
+      else if (myStrNCmp("-Scale", argv[i], 2) == 0 && hasArg) {
+         if (!myStr2Int(argv[++i], scale) || scale < 1) myexit();
+      }
+      else if (myStrNCmp("-Reps", argv[i], 2) == 0 && hasArg) {
+         if (!myStr2Int(argv[++i], reps) || reps < 1) myexit();
+      }
+      else if (myStrNCmp("-Synth", argv[i], 2) == 0 && i + 3 < argc) {
+         MatGenerator gen;
+         int users, movies;
+         if (!myStr2Int(argv[++i], users) || users < 1 ||
+             !myStr2Int(argv[++i], movies) || movies < 1 ||
+             !myStr2Double(argv[++i], gen._density) || gen._density <= 0 ||
+             gen._density > 1)
+            myexit();
+         gen._users = users; gen._movies = movies;
+         synths.push_back(gen);
+      }
+      else if (myStrNCmp("-Circuit", argv[i], 3) == 0 && hasArg)
+         circuits.push_back(argv[++i]);
+      else if (myStrNCmp("-Csv", argv[i], 3) == 0 && hasArg)
+         csvFile = argv[++i];
+      else if (myStrNCmp("-Json", argv[i], 2) == 0 && hasArg)
+         jsonFile = argv[++i];
+      else if (myStrNCmp("-Label", argv[i], 2) == 0 && hasArg)
+         label = argv[++i];
+      else if (myStrNCmp("-Load", argv[i], 3) == 0 && hasArg)
+         loadAddr = argv[++i];
+      else if (myStrNCmp("-Clients", argv[i], 2) == 0 && hasArg) {
+         if (!myStr2Int(argv[++i], clients) || clients < 1) myexit();
+      }
+      else if (myStrNCmp("-Requests", argv[i], 4) == 0 && hasArg) {
+         if (!myStr2Int(argv[++i], requests) || requests < 1) myexit();
+      }
+      else if (myStrNCmp("-K", argv[i], 2) == 0 && hasArg) {
+         if (!myStr2Int(argv[++i], k) || k < 0) myexit();
+      }
+      else {
+         cerr << "Error: unknown argument \"" << argv[i] << "\"!!\n";
+         myexit();
+      }
+   }
+   cout << setprecision(4);
+   if (!loadAddr.empty()) {
+      if (!benchLoad(loadAddr, clients, requests, k)) return 1;
+   }
+   else {
+      if (files.empty() && synths.empty() && circuits.empty())
+         files.push_back("data/ratings.csv");
+      benchKernels(CirMgr().getLatent());
+   }
+   for (size_t i = 0; i < files.size(); ++i) {
+      benchDataset(files[i], files[i]);
+      if (scale > 1) {
+         string tmp = scaleFile(files[i], scale);
+         if (tmp.empty()) continue;
+         ostringstream data;
+         data << files[i] << "x" << scale;
+         benchDataset(tmp, data.str());
+         unlink(tmp.c_str());
+      }
+   }
+   for (size_t i = 0; i < circuits.size(); ++i)
+      benchCircuit(circuits[i]);
+   for (size_t i = 0; i < synths.size(); ++i) {
+      string tmp = synthFile(synths[i]);
+      if (tmp.empty()) continue;
+      ostringstream data;
+      data << "synth-" << synths[i]._users << "x" << synths[i]._movies
+           << "@" << synths[i]._density;
+      benchDataset(tmp, data.str());
+      unlink(tmp.c_str());
+   }
+
+   time_t now = time(0);
+   if (!csvFile.empty() && !writeCsv(csvFile, label, now))
+      cerr << "Error: cannot write \"" << csvFile << "\"!!" << endl;
+   if (!jsonFile.empty() && !writeJson(jsonFile, label, now))
+      cerr << "Error: cannot write \"" << jsonFile << "\"!!" << endl;
+   return 0;
+}
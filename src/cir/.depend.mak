@@ -1,7 +1,42 @@
-cirGate.o: cirGate.cpp cirGate.h cirDef.h cirMgr.h ../../include/util.h \
+cirAig.o: cirAig.cpp cirAig.h cirDef.h
+cirCache.o: cirCache.cpp cirCache.h cirDef.h
+cirCkpt.o: cirCkpt.cpp cirCkpt.h
+cirCmd.o: cirCmd.cpp cirMgr.h cirDef.h cirModel.h cirCache.h cirAig.h \
+ cirGate.h cirCmd.h ../../include/cmdParser.h ../../include/cmdCharDef.h \
+ cirGen.h ../../include/rnGen.h ../../include/util.h \
  ../../include/rnGen.h ../../include/myUsage.h
-cirMgr.o: cirMgr.cpp cirMgr.h cirDef.h cirGate.h ../../include/util.h \
+cirCone.o: cirCone.cpp cirMgr.h cirDef.h cirModel.h cirCache.h cirAig.h \
+ ../../include/util.h ../../include/rnGen.h ../../include/myUsage.h
+cirFraig.o: cirFraig.cpp cirMgr.h cirDef.h cirModel.h cirCache.h cirAig.h \
+ cirSat.h ../../include/rnGen.h ../../include/util.h \
+ ../../include/rnGen.h ../../include/myUsage.h
+cirGate.o: cirGate.cpp cirGate.h cirDef.h cirAig.h cirMgr.h cirModel.h \
+ cirCache.h ../../include/util.h ../../include/rnGen.h \
+ ../../include/myUsage.h
+cirGen.o: cirGen.cpp cirGen.h ../../include/rnGen.h ../../include/util.h \
  ../../include/rnGen.h ../../include/myUsage.h
-cirCmd.o: cirCmd.cpp cirMgr.h cirDef.h cirGate.h cirCmd.h \
- ../../include/cmdParser.h ../../include/cmdCharDef.h \
+cirMgr.o: cirMgr.cpp cirMgr.h cirDef.h cirModel.h cirCache.h cirAig.h \
+ cirGate.h cirGen.h ../../include/rnGen.h cirCkpt.h cirInput.h \
  ../../include/util.h ../../include/rnGen.h ../../include/myUsage.h
+cirModel.o: cirModel.cpp cirModel.h cirDef.h
+cirOpt.o: cirOpt.cpp cirMgr.h cirDef.h cirModel.h cirCache.h cirAig.h \
+ ../../include/util.h ../../include/rnGen.h ../../include/myUsage.h
+cirRec.o: cirRec.cpp cirMgr.h cirDef.h cirModel.h cirCache.h cirAig.h \
+ cirKernel.h ../../include/util.h ../../include/rnGen.h \
+ ../../include/myUsage.h
+cirSat.o: cirSat.cpp cirSat.h
+cirServe.o: cirServe.cpp cirServe.h cirMgr.h cirDef.h cirModel.h \
+ cirCache.h cirAig.h ../../include/util.h ../../include/rnGen.h \
+ ../../include/myUsage.h
+cirSim.o: cirSim.cpp cirMgr.h cirDef.h cirModel.h cirCache.h cirAig.h \
+ ../../include/rnGen.h ../../include/util.h ../../include/rnGen.h \
+ ../../include/myUsage.h
+cirSimilar.o: cirSimilar.cpp cirMgr.h cirDef.h cirModel.h cirCache.h \
+ cirAig.h cirKernel.h ../../include/util.h ../../include/rnGen.h \
+ ../../include/myUsage.h
+cirStream.o: cirStream.cpp cirMgr.h cirDef.h cirModel.h cirCache.h \
+ cirAig.h cirKernel.h cirCkpt.h cirInput.h ../../include/util.h \
+ ../../include/rnGen.h ../../include/myUsage.h
+cirTrain.o: cirTrain.cpp cirMgr.h cirDef.h cirModel.h cirCache.h cirAig.h \
+ cirKernel.h cirCkpt.h ../../include/util.h ../../include/rnGen.h \
+ ../../include/myUsage.h
@@ -1 +1,25 @@
-cir.d: 
+cir.d: ../../include/cirDef.h ../../include/cirMgr.h ../../include/cirKernel.h ../../include/cirGen.h ../../include/cirModel.h ../../include/cirServe.h ../../include/cirCache.h ../../include/cirAig.h 
+../../include/cirDef.h: cirDef.h
+	@rm -f ../../include/cirDef.h
+	@ln -fs ../src/cir/cirDef.h ../../include/cirDef.h
+../../include/cirMgr.h: cirMgr.h
+	@rm -f ../../include/cirMgr.h
+	@ln -fs ../src/cir/cirMgr.h ../../include/cirMgr.h
+../../include/cirKernel.h: cirKernel.h
+	@rm -f ../../include/cirKernel.h
+	@ln -fs ../src/cir/cirKernel.h ../../include/cirKernel.h
+../../include/cirGen.h: cirGen.h
+	@rm -f ../../include/cirGen.h
+	@ln -fs ../src/cir/cirGen.h ../../include/cirGen.h
+../../include/cirModel.h: cirModel.h
+	@rm -f ../../include/cirModel.h
+	@ln -fs ../src/cir/cirModel.h ../../include/cirModel.h
+../../include/cirServe.h: cirServe.h
+	@rm -f ../../include/cirServe.h
+	@ln -fs ../src/cir/cirServe.h ../../include/cirServe.h
+../../include/cirCache.h: cirCache.h
+	@rm -f ../../include/cirCache.h
+	@ln -fs ../src/cir/cirCache.h ../../include/cirCache.h
+../../include/cirAig.h: cirAig.h
+	@rm -f ../../include/cirAig.h
+	@ln -fs ../src/cir/cirAig.h ../../include/cirAig.h
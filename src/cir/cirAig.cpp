@@ -0,0 +1,145 @@
+/****************************************************************************
+  FileName     [ cirAig.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define the compact store of an AIG ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include "cirAig.h"
+
+using namespace std;
+
+/**************************************/
+/*   class CirAig member functions    */
+/**************************************/
+void
+CirAig::reset(unsigned size)
+{
+   clear();
+   _type.assign(size, UNDEF_GATE);
+   _fanin.assign(2 * size_t(size), 0);
+   _line.assign(size, 0);
+   _fanoutStart.assign(size_t(size) + 1, 0);
+   _fanoutEnd.assign(size, 0);
+   _mark.assign(size, 0);
+   if (size) _type[0] = CONST_GATE;
+}
+
+void
+CirAig::clear()
+{
+   _type.clear(); _fanin.clear(); _line.clear();
+   _fanoutStart.clear(); _fanoutEnd.clear(); _fanout.clear();
+   _piList.clear(); _poList.clear(); _aigList.clear();
+   _symbols.clear();
+   _mark.clear();
+   _markId = 0;
+}
+
+void
+CirAig::setPi(unsigned id, unsigned line)
+{
+   _type[id] = PI_GATE;
+   _line[id] = line;
+   _piList.push_back(id);
+}
+
+void
+CirAig::setPo(unsigned id, unsigned line, unsigned lit)
+{
+   _type[id] = PO_GATE;
+   _line[id] = line;
+   _fanin[2 * id] = lit;
+   _poList.push_back(id);
+}
+
+void
+CirAig::setAig(unsigned id, unsigned line, unsigned lit0, unsigned lit1)
+{
+   _type[id] = AIG_GATE;
+   _line[id] = line;
+   _fanin[2 * id] = lit0;
+   _fanin[2 * id + 1] = lit1;
+   _aigList.push_back(id);
+}
+
+void
+CirAig::removeAig(unsigned id)
+{
+   _type[id] = UNDEF_GATE;
+   _fanin[2 * id] = _fanin[2 * id + 1] = 0;
+   _line[id] = 0;
+}
+
+void
+CirAig::compactAigList()
+{
+   size_t aigs = 0;
+   for (size_t i = 0, n = _aigList.size(); i < n; ++i)
+      if (_type[_aigList[i]] == AIG_GATE) _aigList[aigs++] = _aigList[i];
+   _aigList.resize(aigs);
+}
+
+const string&
+CirAig::getSymbol(unsigned id) const
+{
+   static const string none;
+   unordered_map<unsigned, string>::const_iterator it = _symbols.find(id);
+   return it == _symbols.end() ? none : it->second;
+}
+
+// Counting sort of the fanin edges by fanin, so that each list keeps the
+// order in which the fanouts are visited here
+void
+CirAig::buildFanouts()
+{
+   compactAigList();
+   _fanoutStart.assign(size_t(size()) + 1, 0);
+   for (size_t i = 0, n = _aigList.size(); i < n; ++i) {
+      ++_fanoutStart[_fanin[2 * _aigList[i]] / 2 + 1];
+      ++_fanoutStart[_fanin[2 * _aigList[i] + 1] / 2 + 1];
+   }
+   for (size_t i = 0, n = _poList.size(); i < n; ++i)
+      ++_fanoutStart[_fanin[2 * _poList[i]] / 2 + 1];
+   for (size_t id = 1; id < _fanoutStart.size(); ++id)
+      _fanoutStart[id] += _fanoutStart[id - 1];
+
+   _fanout.resize(_fanoutStart.back());
+   IdList next(_fanoutStart.begin(), _fanoutStart.end() - 1);
+   for (size_t i = 0, n = _aigList.size(); i < n; ++i) {
+      unsigned id = _aigList[i];
+      for (int j = 0; j < 2; ++j) {
+         unsigned lit = _fanin[2 * id + j];
+         _fanout[next[lit / 2]++] = 2 * id + (lit & 1);
+      }
+   }
+   for (size_t i = 0, n = _poList.size(); i < n; ++i) {
+      unsigned id = _poList[i], lit = _fanin[2 * id];
+      _fanout[next[lit / 2]++] = 2 * id + (lit & 1);
+   }
+   _fanoutEnd.swap(next);
+}
+
+// The list shrinks from its end; the slot freed is not reused until the
+// next buildFanouts()
+void
+CirAig::removeFanout(unsigned id, unsigned out)
+{
+   unsigned* f = _fanout.data() + _fanoutStart[id];
+   unsigned* end = _fanout.data() + _fanoutEnd[id];
+   for (; f != end; ++f)
+      if (*f / 2 == out) break;
+   if (f == end) return;
+   for (; f + 1 != end; ++f) *f = f[1];
+   --_fanoutEnd[id];
+}
+
+void
+CirAig::newMark() const
+{
+   if (++_markId == 0) {   // wrapped around
+      _mark.assign(_mark.size(), 0);
+      _markId = 1;
+   }
+}
@@ -0,0 +1,91 @@
+/****************************************************************************
+  FileName     [ cirAig.h ]
+  PackageName  [ cir ]
+  Synopsis     [ Define the compact store of an AIG ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef CIR_AIG_H
+#define CIR_AIG_H
+
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include "cirDef.h"
+
+using namespace std;
+
+// Gates of a circuit in flat arrays indexed by gate id. A fanin is a
+// literal id*2+inv; a PO has one fanin and an AIG two. An id that is
+// used as a fanin but never defined is UNDEF. Fanouts, built once by
+// buildFanouts(), are a CSR table of literals out*2+inv. Symbols of the
+// PIs and POs are kept aside, as most gates have none.
+class CirAig
+{
+public:
+   CirAig() : _markId(0) {}
+
+   // Gates 0..size-1, all UNDEF but CONST 0
+   void reset(unsigned size);
+   void clear();
+   unsigned size() const { return _type.size(); }
+
+   void setPi(unsigned id, unsigned line);
+   void setPo(unsigned id, unsigned line, unsigned lit);
+   void setAig(unsigned id, unsigned line, unsigned lit0, unsigned lit1);
+   void setSymbol(unsigned id, const string& symbol) { _symbols[id] = symbol; }
+   // Edits leave the fanouts stale until buildFanouts() is called again
+   void setFanin(unsigned id, int i, unsigned lit) { _fanin[2 * id + i] = lit; }
+   void removeAig(unsigned id);   // it becomes UNDEF
+   void compactAigList();         // drops the removed AIGs
+
+   GateType getType(unsigned id) const { return GateType(_type[id]); }
+   unsigned getFanin(unsigned id, int i) const { return _fanin[2 * id + i]; }
+   unsigned getLineNo(unsigned id) const { return _line[id]; }
+   const string& getSymbol(unsigned id) const;
+   // PIs and POs in file order, AIGs in the order they are defined
+   const IdList& getPiList() const { return _piList; }
+   const IdList& getPoList() const { return _poList; }
+   const IdList& getAigList() const { return _aigList; }
+
+   // The fanouts of each gate: those of the AIGs in getAigList() order,
+   // then those of the POs. Drops the removed AIGs from getAigList().
+   void buildFanouts();
+   // Drop a fanout "out" of "id" in place, keeping the order of the others
+   void removeFanout(unsigned id, unsigned out);
+   const unsigned* fanoutBegin(unsigned id) const {
+      return _fanout.data() + _fanoutStart[id];
+   }
+   const unsigned* fanoutEnd(unsigned id) const {
+      return _fanout.data() + _fanoutEnd[id];
+   }
+   unsigned getFanoutNum(unsigned id) const {
+      return _fanoutEnd[id] - _fanoutStart[id];
+   }
+   // An UNDEF gate exists only if something refers to it
+   bool exists(unsigned id) const {
+      return id < size() && (_type[id] != UNDEF_GATE || getFanoutNum(id));
+   }
+
+   // Marks of a traversal; newMark() unmarks all gates
+   void newMark() const;
+   bool isMarked(unsigned id) const { return _mark[id] == _markId; }
+   void setMark(unsigned id) const { _mark[id] = _markId; }
+
+private:
+   vector<unsigned char>           _type;         // GateType
+   IdList                          _fanin;        // [2*id], [2*id+1]
+   IdList                          _line;         // 0-based line in the file
+   IdList                          _fanoutStart;  // size()+1 entries
+   IdList                          _fanoutEnd;    // of each list, <= next start
+   IdList                          _fanout;
+   IdList                          _piList;
+   IdList                          _poList;
+   IdList                          _aigList;
+   unordered_map<unsigned, string> _symbols;
+   mutable IdList                  _mark;
+   mutable unsigned                _markId;
+};
+
+#endif // CIR_AIG_H
@@ -0,0 +1,151 @@
+/****************************************************************************
+  FileName     [ cirCache.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define the result cache of top-K recommendations ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include "cirCache.h"
+
+using namespace std;
+
+// Bytes of the list and hash nodes of an entry or a user floor
+#define MAT_CACHE_NODE  64
+
+/**************************************/
+/*   Static varaibles and functions   */
+/**************************************/
+static inline unsigned long long
+cacheKey(unsigned user, unsigned k, bool excludeRated)
+{
+   return (unsigned long long)user << 32 | (unsigned long long)k << 1 |
+          excludeRated;
+}
+
+static inline size_t
+entryBytes(const ScoreList& result)
+{
+   return MAT_CACHE_NODE + sizeof(ScoreList) + sizeof(unsigned long long) * 2 +
+          result.capacity() * sizeof(MovieScore);
+}
+
+/**************************************/
+/*   class MatRecCache functions      */
+/**************************************/
+unsigned long long
+MatRecCache::Shard::floor(unsigned user) const
+{
+   unordered_map<unsigned, unsigned long long>::const_iterator it =
+      _userFloor.find(user);
+   return it == _userFloor.end() || it->second < _floor ? _floor : it->second;
+}
+
+void
+MatRecCache::Shard::erase(EntryIter it)
+{
+   _bytes -= entryBytes(it->_result);
+   _map.erase(it->_key);
+   _lru.erase(it);
+}
+
+void
+MatRecCache::setCapacity(size_t bytes)
+{
+   for (int i = 0; i < MAT_CACHE_SHARDS; ++i) {
+      Shard& s = _shards[i];
+      lock_guard<mutex> lock(s._mutex);
+      s._lru.clear();
+      s._map.clear();
+      s._bytes = 0;
+   }
+   _capacity = bytes;
+}
+
+bool
+MatRecCache::lookup(unsigned user, unsigned k, bool excludeRated,
+                    ScoreList& result)
+{
+   if (!enabled()) return false;
+   Shard& s = shardOf(user);
+   lock_guard<mutex> lock(s._mutex);
+   unordered_map<unsigned long long, EntryIter>::iterator it =
+      s._map.find(cacheKey(user, k, excludeRated));
+   if (it == s._map.end()) { ++s._misses; return false; }
+   EntryIter e = it->second;
+   if (e->_serial < s.floor(user)) {
+      s.erase(e);
+      ++s._misses;
+      return false;
+   }
+   s._lru.splice(s._lru.begin(), s._lru, e);
+   result = e->_result;
+   ++s._hits;
+   return true;
+}
+
+void
+MatRecCache::insert(unsigned user, unsigned k, bool excludeRated,
+                    unsigned long long serial, const ScoreList& result)
+{
+   size_t capacity = _capacity.load() / MAT_CACHE_SHARDS;
+   size_t bytes = entryBytes(result);
+   if (bytes > capacity) return;
+   Shard& s = shardOf(user);
+   lock_guard<mutex> lock(s._mutex);
+   if (serial < s.floor(user)) return;   // computed on a dropped model
+   unsigned long long key = cacheKey(user, k, excludeRated);
+   unordered_map<unsigned long long, EntryIter>::iterator it =
+      s._map.find(key);
+   if (it != s._map.end()) {
+      if (it->second->_serial >= serial) return;
+      s.erase(it->second);
+   }
+   while (!s._lru.empty() && s._bytes + bytes > capacity) {
+      s.erase(--s._lru.end());
+      ++s._evictions;
+   }
+   Entry e = { key, serial, result };
+   s._lru.push_front(e);
+   s._map[key] = s._lru.begin();
+   s._bytes += entryBytes(s._lru.front()._result);
+}
+
+void
+MatRecCache::invalidate(unsigned user, unsigned long long serial)
+{
+   Shard& s = shardOf(user);
+   lock_guard<mutex> lock(s._mutex);
+   unsigned long long& f = s._userFloor[user];
+   if (f < serial) f = serial;
+}
+
+void
+MatRecCache::invalidateAll(unsigned long long serial)
+{
+   for (int i = 0; i < MAT_CACHE_SHARDS; ++i) {
+      Shard& s = _shards[i];
+      lock_guard<mutex> lock(s._mutex);
+      s._lru.clear();
+      s._map.clear();
+      s._userFloor.clear();
+      s._bytes = 0;
+      if (s._floor < serial) s._floor = serial;
+   }
+}
+
+void
+MatRecCache::getStats(MatCacheStats& stats) const
+{
+   stats._hits = stats._misses = stats._evictions = 0;
+   stats._entries = stats._bytes = 0;
+   for (int i = 0; i < MAT_CACHE_SHARDS; ++i) {
+      const Shard& s = _shards[i];
+      lock_guard<mutex> lock(s._mutex);
+      stats._hits += s._hits;
+      stats._misses += s._misses;
+      stats._evictions += s._evictions;
+      stats._entries += s._lru.size();
+      stats._bytes += s._bytes + s._userFloor.size() * MAT_CACHE_NODE;
+   }
+}
@@ -0,0 +1,94 @@
+/****************************************************************************
+  FileName     [ cirCache.h ]
+  PackageName  [ cir ]
+  Synopsis     [ Define the result cache of top-K recommendations ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef CIR_CACHE_H
+#define CIR_CACHE_H
+
+#include <list>
+#include <mutex>
+#include <atomic>
+#include <unordered_map>
+#include "cirDef.h"
+
+using namespace std;
+
+#define MAT_CACHE_SHARDS  16
+#define MAT_CACHE_MB      64   // default capacity
+
+struct MatCacheStats
+{
+   unsigned long long   _hits;
+   unsigned long long   _misses;
+   unsigned long long   _evictions;
+   size_t               _entries;
+   size_t               _bytes;
+
+   double hitRate() const {
+      return _hits + _misses ? double(_hits) / (_hits + _misses) : 0.0;
+   }
+};
+
+// Results of MatModel::recommend() keyed by user, k and excludeRated, in
+// LRU shards picked by user. Each result is tagged with the serial of the
+// model it was computed on. A result is valid if its serial is not below
+// the floor of its user: invalidate() raises the floor of one user and
+// invalidateAll() that of everyone, so a result computed on an older model
+// is neither returned nor inserted afterwards. Entries of a dropped user
+// are reclaimed lazily, on lookup or by eviction.
+class MatRecCache
+{
+public:
+   MatRecCache() : _capacity(size_t(MAT_CACHE_MB) << 20) {}
+
+   // Bound of the footprint in bytes; 0 disables the cache
+   void setCapacity(size_t bytes);
+   size_t getCapacity() const { return _capacity.load(); }
+   bool enabled() const { return _capacity.load() != 0; }
+
+   bool lookup(unsigned user, unsigned k, bool excludeRated,
+               ScoreList& result);
+   void insert(unsigned user, unsigned k, bool excludeRated,
+               unsigned long long serial, const ScoreList& result);
+   void invalidate(unsigned user, unsigned long long serial);
+   void invalidateAll(unsigned long long serial);
+   void getStats(MatCacheStats& stats) const;
+
+private:
+   struct Entry
+   {
+      unsigned long long   _key;
+      unsigned long long   _serial;
+      ScoreList            _result;
+   };
+   typedef list<Entry>::iterator EntryIter;
+
+   struct Shard
+   {
+      Shard() : _floor(0), _bytes(0), _hits(0), _misses(0), _evictions(0) {}
+
+      mutable mutex                                    _mutex;
+      list<Entry>                                      _lru;  // newest first
+      unordered_map<unsigned long long, EntryIter>     _map;
+      unordered_map<unsigned, unsigned long long>      _userFloor;
+      unsigned long long                               _floor;
+      size_t                                           _bytes;
+      unsigned long long                               _hits;
+      unsigned long long                               _misses;
+      unsigned long long                               _evictions;
+
+      unsigned long long floor(unsigned user) const;
+      void erase(EntryIter it);
+   };
+
+   atomic<size_t>   _capacity;
+   Shard            _shards[MAT_CACHE_SHARDS];
+
+   Shard& shardOf(unsigned user) { return _shards[user % MAT_CACHE_SHARDS]; }
+};
+
+#endif // CIR_CACHE_H
@@ -0,0 +1,106 @@
+/****************************************************************************
+  FileName     [ cirCkpt.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define training checkpoints and their writer thread ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <iostream>
+#include <fstream>
+#include <cstring>
+#include <cstdio>
+#include "cirCkpt.h"
+
+using namespace std;
+
+/**************************************/
+/*   struct MatCkpt functions         */
+/**************************************/
+// Written to "<fileName>.tmp" and renamed, so a crash in the middle of a
+// write leaves the previous checkpoint intact
+bool
+MatCkpt::write(const string& fileName) const
+{
+   string tmpName = fileName + ".tmp";
+   ofstream outFile(tmpName.c_str(), ios::out | ios::binary);
+   if (!outFile) return false;
+   outFile.write((const char*)&_header, sizeof(_header));
+   outFile.write((const char*)&_user[0], _user.size() * sizeof(double));
+   outFile.write((const char*)&_movie[0], _movie.size() * sizeof(double));
+   outFile.close();
+   if (!outFile) { remove(tmpName.c_str()); return false; }
+   return rename(tmpName.c_str(), fileName.c_str()) == 0;
+}
+
+bool
+MatCkpt::read(const string& fileName)
+{
+   ifstream inFile(fileName.c_str(), ios::in | ios::binary);
+   if (!inFile) {
+      cerr << "Cannot open checkpoint \"" << fileName << "\"!!" << endl;
+      return false;
+   }
+   inFile.read((char*)&_header, sizeof(_header));
+   if (!inFile || memcmp(_header._magic, MAT_CKPT_MAGIC, 4) != 0 ||
+       _header._version != MAT_CKPT_VERSION || _header._latent <= 0 ||
+       _header._maxUserId < 0 || _header._maxMovieId < 0) {
+      cerr << "Illegal checkpoint \"" << fileName << "\"!!" << endl;
+      return false;
+   }
+   _user.resize(size_t(_header._maxUserId + 1) * _header._latent);
+   _movie.resize(size_t(_header._maxMovieId + 1) * _header._latent);
+   inFile.read((char*)&_user[0], _user.size() * sizeof(double));
+   inFile.read((char*)&_movie[0], _movie.size() * sizeof(double));
+   if (!inFile) {
+      cerr << "Checkpoint \"" << fileName << "\" is truncated!!" << endl;
+      return false;
+   }
+   return true;
+}
+
+/**************************************/
+/*   class MatCkptWriter functions    */
+/**************************************/
+MatCkptWriter::MatCkptWriter(const string& fileName)
+   : _fileName(fileName), _hasPending(false), _done(false),
+     _thread(&MatCkptWriter::run, this) {}
+
+MatCkptWriter::~MatCkptWriter()
+{
+   {
+      lock_guard<mutex> lock(_mutex);
+      _done = true;
+   }
+   _cond.notify_one();
+   _thread.join();
+}
+
+void
+MatCkptWriter::submit(MatCkpt& ckpt)
+{
+   {
+      lock_guard<mutex> lock(_mutex);
+      swap(_pending, ckpt);
+      _hasPending = true;
+   }
+   _cond.notify_one();
+}
+
+void
+MatCkptWriter::run()
+{
+   MatCkpt writing;
+   while (true) {
+      {
+         unique_lock<mutex> lock(_mutex);
+         while (!_hasPending && !_done) _cond.wait(lock);
+         if (!_hasPending) return;
+         swap(_pending, writing);
+         _hasPending = false;
+      }
+      if (!writing.write(_fileName))
+         cerr << "Error: cannot write checkpoint \"" << _fileName << "\"!!"
+              << endl;
+   }
+}
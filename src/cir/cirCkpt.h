@@ -0,0 +1,76 @@
+/****************************************************************************
+  FileName     [ cirCkpt.h ]
+  PackageName  [ cir ]
+  Synopsis     [ Define training checkpoints and their writer thread ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef CIR_CKPT_H
+#define CIR_CKPT_H
+
+#include <string>
+#include <vector>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+
+using namespace std;
+
+// Header of a checkpoint, followed by the user factors and then the movie
+// factors, both row-major doubles
+#define MAT_CKPT_MAGIC    "MATC"
+#define MAT_CKPT_VERSION  2
+
+struct MatCkptHeader
+{
+   char      _magic[4];
+   unsigned  _version;
+   int       _epoch;        // epochs done
+   unsigned  _seed;         // with _epoch, replays the rating order
+   int       _order;        // MatOrderType
+   int       _latent;
+   int       _maxUserId;
+   int       _maxMovieId;
+   int       _ratings;
+   double    _learningRate;
+   double    _lambda;
+   double    _validRatio;
+   int       _split;        // MatSplitType
+};
+
+struct MatCkpt
+{
+   MatCkptHeader   _header;
+   vector<double>  _user;
+   vector<double>  _movie;
+
+   bool write(const string& fileName) const;
+   bool read(const string& fileName);
+};
+
+// Writes checkpoints on its own thread. submit() swaps the caller's buffer
+// with the pending one and returns at once; a checkpoint that is still
+// pending when the next one arrives is dropped, so the trainer never waits
+// for the disk.
+class MatCkptWriter
+{
+public:
+   MatCkptWriter(const string& fileName);
+   ~MatCkptWriter();   // writes the last pending checkpoint
+
+   void submit(MatCkpt& ckpt);
+
+private:
+   string              _fileName;
+   MatCkpt             _pending;
+   bool                _hasPending;
+   bool                _done;
+   mutex               _mutex;
+   condition_variable  _cond;
+   thread              _thread;
+
+   void run();
+};
+
+#endif // CIR_CKPT_H
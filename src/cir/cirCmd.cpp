@@ -12,6 +12,7 @@
 #include "cirMgr.h"
 #include "cirGate.h"
 #include "cirCmd.h"
+#include "cirGen.h"
 #include "util.h"
 
 using namespace std;
@@ -24,8 +25,23 @@ initCirCmd()
    if (!(cmdMgr->regCmd("MATRead", 4, new MatReadCmd) &&
          cmdMgr->regCmd("MATPrint", 4, new MatPrintCmd) &&
          cmdMgr->regCmd("MATTrain", 4, new MatTrainCmd) &&
+         cmdMgr->regCmd("MATQuery", 4, new MatQueryCmd) &&
+         cmdMgr->regCmd("MATGenerate", 4, new MatGenerateCmd) &&
+         cmdMgr->regCmd("MATUsage", 4, new MatUsageCmd) &&
+         cmdMgr->regCmd("MATSTAtus", 6, new MatStatusCmd) &&
+         cmdMgr->regCmd("MATSTOp", 6, new MatStopCmd) &&
+         cmdMgr->regCmd("MATSTReam", 6, new MatStreamCmd) &&
+         cmdMgr->regCmd("MATCache", 4, new MatCacheCmd) &&
+         cmdMgr->regCmd("MATSImilar", 5, new MatSimilarCmd) &&
+         cmdMgr->regCmd("CIRRead", 4, new CirReadCmd) &&
          cmdMgr->regCmd("CIRGate", 4, new CirGateCmd) &&
-         cmdMgr->regCmd("CIRWrite", 4, new CirWriteCmd)
+         cmdMgr->regCmd("CIRWrite", 4, new CirWriteCmd) &&
+         cmdMgr->regCmd("CIRCone", 4, new CirConeCmd) &&
+         cmdMgr->regCmd("CIRSIMulate", 6, new CirSimCmd) &&
+         cmdMgr->regCmd("CIRSWeep", 5, new CirSweepCmd) &&
+         cmdMgr->regCmd("CIROPTimize", 6, new CirOptCmd) &&
+         cmdMgr->regCmd("CIRSTRash", 6, new CirStrashCmd) &&
+         cmdMgr->regCmd("CIRFraig", 4, new CirFraigCmd)
       )) {
       cerr << "Registering \"cir\" commands fails... exiting" << endl;
       return false;
@@ -38,6 +54,10 @@ enum CirCmdState
    // Order matters! Do not change the order!!
    CIRINIT,
    CIRREAD,
+   CIROPT,
+   CIRSTRASH,
+   CIRSIMULATE,
+   CIRFRAIG,
    // dummy end
    CIRCMDTOT
 };
@@ -45,7 +65,8 @@ enum CirCmdState
 static CirCmdState curCmd = CIRINIT;
 
 //----------------------------------------------------------------------
-//    MATRead <(string fileName)> [-Replace]
+//    MATRead <(string fileName) | -> [-Replace]
+//            [-Since (int timestamp)] [-Until (int timestamp)]
 //----------------------------------------------------------------------
 CmdExecStatus
 MatReadCmd::exec(const string& option)
@@ -57,21 +78,49 @@ MatReadCmd::exec(const string& option)
    if (options.empty())
       return CmdExec::errorOption(CMD_OPT_MISSING, "");
 
-   bool doReplace = false;
+   bool doReplace = false, doSince = false, doUntil = false;
+   int since = 0, until = 0;
+   size_t untilAt = 0;
    string fileName;
    for (size_t i = 0, n = options.size(); i < n; ++i) {
       if (myStrNCmp("-Replace", options[i], 2) == 0) {
          if (doReplace) return CmdExec::errorOption(CMD_OPT_EXTRA,options[i]);
          doReplace = true;
       }
+      else if (myStrNCmp("-Since", options[i], 2) == 0) {
+         if (doSince) return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Int(options[i], since) || since < 0)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doSince = true;
+      }
+      else if (myStrNCmp("-Until", options[i], 2) == 0) {
+         if (doUntil) return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Int(options[i], until) || until <= 0)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doUntil = true;
+         untilAt = i;
+      }
       else {
          if (fileName.size())
             return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
          fileName = options[i];
       }
    }
+   // -Since may come after -Until
+   if (doUntil && until <= since)
+      return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[untilAt]);
 
+   if (fileName.empty())
+      return CmdExec::errorOption(CMD_OPT_MISSING, "");
    if (cirMgr != 0) {
+      if (cirMgr->isTraining()) {
+         cerr << "Error: training is in progress (see MATSTOp)!!" << endl;
+         return CMD_EXEC_ERROR;
+      }
       if (doReplace) {
          cerr << "Note: original circuit is replaced..." << endl;
          curCmd = CIRINIT;
@@ -83,6 +132,7 @@ MatReadCmd::exec(const string& option)
       }
    }
    cirMgr = new CirMgr;
+   cirMgr->setTimeRange(since, doUntil ? unsigned(until) : UINT_MAX);
 
    if (!cirMgr->readMatrix(fileName)) {
       curCmd = CIRINIT;
@@ -98,7 +148,9 @@ MatReadCmd::exec(const string& option)
 void
 MatReadCmd::usage(ostream& os) const
 {
-   os << "Usage: MATRead <(string fileName)> [-Replace]" << endl;
+   os << "Usage: MATRead <(string fileName) | -> [-Replace]" << endl
+      << "               [-Since (int timestamp)] [-Until (int timestamp)]"
+      << endl;
 }
 
 void
@@ -109,7 +161,7 @@ MatReadCmd::help() const
 }
 
 //----------------------------------------------------------------------
-//    MATPrint [-SUmmary | -SEttings]
+//    MATPrint [-SUmmary | -SEttings | -PI | -PO | -FLoating | -FECpairs]
 //----------------------------------------------------------------------
 CmdExecStatus
 MatPrintCmd::exec(const string& option)
@@ -133,10 +185,8 @@ MatPrintCmd::exec(const string& option)
       cirMgr->printPOs();
    else if (myStrNCmp("-FLoating", token, 3) == 0)
       cirMgr->printFloatGates();
-/*
    else if (myStrNCmp("-FECpairs", token, 4) == 0)
       cirMgr->printFECPairs();
-*/
    else
       return CmdExec::errorOption(CMD_OPT_ILLEGAL, token);
 
@@ -146,10 +196,8 @@ MatPrintCmd::exec(const string& option)
 void
 MatPrintCmd::usage(ostream& os) const
 {  
-   os << "Usage: MATPrint [-SUmmary | -SEttings]"
-      << endl;
-//   os << "Usage: CIRPrint [-Summary | -Netlist | -PI | -PO | -FLoating "
-//      << "| -FECpairs]" << endl;
+   os << "Usage: MATPrint [-SUmmary | -SEttings | -PI | -PO | -FLoating "
+      << "| -FECpairs]" << endl;
 }
 
 void
@@ -159,7 +207,12 @@ MatPrintCmd::help() const
 }
 
 //----------------------------------------------------------------------
-//    MATTrain
+//    MATTrain [-Order <User | Shuffle | Block | Hilbert>]
+//             [-ITerations (int n)] [-Target (double rmse)]
+//             [-Validation (double ratio)] [-Split <Random | Time>]
+//             [-Log (string jsonlFile)]
+//             [-CHeckpoint (string file) [-Every (int n)]]
+//             [-Resume (string file)] [-Quantize <On | Off>] [-Background]
 //----------------------------------------------------------------------
 CmdExecStatus
 MatTrainCmd::exec(const string& option)
@@ -168,15 +221,143 @@ MatTrainCmd::exec(const string& option)
       cerr << "Error: mattrix is not yet constructed!!" << endl;
       return CMD_EXEC_ERROR;
    }
+   if (cirMgr->isTraining()) {
+      cerr << "Error: training is in progress (see MATSTOp)!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
    // check option
    vector<string> options;
-   CmdExec::lexOptions(option, options);
+   if (!CmdExec::lexOptions(option, options))
+      return CMD_EXEC_ERROR;
+
+   bool doOrder = false, doIter = false, doTarget = false;
+   bool doValid = false, doLog = false, doBackground = false;
+   bool doEvery = false, doSplit = false, doQuantize = false;
+   // nothing is set before all the options are checked
+   MatOrderType order = ORDER_USER;
+   MatSplitType split = SPLIT_RANDOM;
+   int iters = 0, every = 10;
+   double rmse = 0, ratio = 0;
+   bool quantize = false;
+   string logFile, ckptFile, resumeFile;
+   for (size_t i = 0, n = options.size(); i < n; ++i) {
+      if (myStrNCmp("-Order", options[i], 2) == 0) {
+         if (doOrder) return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (myStrNCmp("User", options[i], 1) == 0) order = ORDER_USER;
+         else if (myStrNCmp("Shuffle", options[i], 1) == 0)
+            order = ORDER_SHUFFLE;
+         else if (myStrNCmp("Block", options[i], 1) == 0)
+            order = ORDER_BLOCK;
+         else if (myStrNCmp("Hilbert", options[i], 1) == 0)
+            order = ORDER_HILBERT;
+         else return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doOrder = true;
+      }
+      else if (myStrNCmp("-ITerations", options[i], 3) == 0) {
+         if (doIter) return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Int(options[i], iters) || iters < 2)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doIter = true;
+      }
+      else if (myStrNCmp("-Target", options[i], 2) == 0) {
+         if (doTarget) return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Double(options[i], rmse) || rmse < 0)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doTarget = true;
+      }
+      else if (myStrNCmp("-Validation", options[i], 2) == 0) {
+         if (doValid) return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Double(options[i], ratio) || ratio < 0 || ratio >= 1)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doValid = true;
+      }
+      else if (myStrNCmp("-Split", options[i], 2) == 0) {
+         if (doSplit) return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (myStrNCmp("Random", options[i], 1) == 0) split = SPLIT_RANDOM;
+         else if (myStrNCmp("Time", options[i], 1) == 0) split = SPLIT_TIME;
+         else return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doSplit = true;
+      }
+      else if (myStrNCmp("-Log", options[i], 2) == 0) {
+         if (doLog) return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         logFile = options[i];
+         doLog = true;
+      }
+      else if (myStrNCmp("-CHeckpoint", options[i], 3) == 0) {
+         if (ckptFile.size())
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         ckptFile = options[i];
+      }
+      else if (myStrNCmp("-Every", options[i], 2) == 0) {
+         if (doEvery) return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Int(options[i], every) || every < 1)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doEvery = true;
+      }
+      else if (myStrNCmp("-Resume", options[i], 2) == 0) {
+         if (resumeFile.size())
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         resumeFile = options[i];
+      }
+      else if (myStrNCmp("-Quantize", options[i], 2) == 0) {
+         if (doQuantize)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (myStrNCmp("ON", options[i], 2) == 0) quantize = true;
+         else if (myStrNCmp("OFf", options[i], 2) == 0) quantize = false;
+         else return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doQuantize = true;
+      }
+      else if (myStrNCmp("-Background", options[i], 2) == 0) {
+         if (doBackground)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         doBackground = true;
+      }
+      else return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+   }
 
-   if (!options.empty())
-      return CmdExec::errorOption(CMD_OPT_EXTRA, options[0]);
+   if (doEvery && ckptFile.empty())
+      return CmdExec::errorOption(CMD_OPT_MISSING, "-CHeckpoint");
+   // the settings of the checkpoint win over -Order, -Validation and -Split
+   if (resumeFile.size()) {
+      if (!cirMgr->setResume(resumeFile)) return CMD_EXEC_ERROR;
+   }
+   else {
+      if (doOrder) cirMgr->setOrder(order);
+      if (doValid) cirMgr->setValidRatio(ratio);
+      if (doSplit) cirMgr->setSplit(split);
+   }
+   if (doIter) cirMgr->setIterations(iters);
+   if (doTarget) cirMgr->setTarget(rmse);
+   if (doLog) cirMgr->setLogFile(logFile);
+   if (doQuantize) cirMgr->setQuantize(quantize);
+   if (ckptFile.size()) cirMgr->setCheckpoint(ckptFile, every);
 
    assert(curCmd != CIRINIT);
-   cirMgr->train();
+   if (doBackground) {
+      cirMgr->trainBackground();
+      cout << "Training is started in background (see MATSTAtus)." << endl;
+   }
+   else cirMgr->train();
 
    return CMD_EXEC_DONE;
 }
@@ -184,7 +365,16 @@ MatTrainCmd::exec(const string& option)
 void
 MatTrainCmd::usage(ostream& os) const
 {
-   os << "Usage: MATTrain" << endl;
+   os << "Usage: MATTrain [-Order <User | Shuffle | Block | Hilbert>]" << endl
+      << "                [-ITerations (int n)] [-Target (double rmse)]"
+      << endl
+      << "                [-Validation (double ratio)] [-Split <Random | Time>]"
+      << endl
+      << "                [-Log (string jsonlFile)]" << endl
+      << "                [-CHeckpoint (string file) [-Every (int n)]]" << endl
+      << "                [-Resume (string file)] [-Quantize <On | Off>]"
+      << endl
+      << "                [-Background]" << endl;
 }
 
 void
@@ -195,117 +385,240 @@ MatTrainCmd::help() const
 }
 
 //----------------------------------------------------------------------
-//    CIRGate <<(int gateId)> [<-FANIn | -FANOut><(int level)>]>
+//    MATQuery <(int userId)> [-K (int k) | -Movie (int movieId)] [-All]
 //----------------------------------------------------------------------
 CmdExecStatus
-CirGateCmd::exec(const string& option)
+MatQueryCmd::exec(const string& option)
 {
    if (!cirMgr) {
-      cerr << "Error: circuit has not been read!!" << endl;
+      cerr << "Error: mattrix is not yet constructed!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   // the last published model is read, even during training
+   if (!cirMgr->hasModel()) {
+      cerr << "Error: mattrix is not yet trained!!" << endl;
       return CMD_EXEC_ERROR;
    }
-
    // check option
    vector<string> options;
    if (!CmdExec::lexOptions(option, options))
       return CMD_EXEC_ERROR;
-
    if (options.empty())
       return CmdExec::errorOption(CMD_OPT_MISSING, "");
 
-   int gateId = -1, level = 0;
-   bool doFanin = false, doFanout = false;
-   CirGate* thisGate = 0;
+   int userId = -1, k = 10, movieId = -1;
+   bool doK = false, doAll = false;
    for (size_t i = 0, n = options.size(); i < n; ++i) {
-      bool checkLevel = false;
-      if (myStrNCmp("-FANIn", options[i], 5) == 0) {
-         if (doFanin || doFanout)
+      if (myStrNCmp("-K", options[i], 2) == 0) {
+         if (doK || movieId >= 0)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Int(options[i], k) || k <= 0)
             return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
-         doFanin = true;
-         checkLevel = true;
+         doK = true;
       }
-      else if (myStrNCmp("-FANOut", options[i], 5) == 0) {
-         if (doFanin || doFanout)
+      else if (myStrNCmp("-Movie", options[i], 2) == 0) {
+         if (doK || movieId >= 0)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Int(options[i], movieId) || movieId < 0)
             return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
-         doFanout = true;
-         checkLevel = true;
       }
-      else if (!thisGate) {
-         if (!myStr2Int(options[i], gateId) || gateId < 0)
-            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
-         thisGate = cirMgr->getGate(gateId);
-         if (!thisGate) {
-            cerr << "Error: Gate(" << gateId << ") not found!!" << endl;
-            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[0]);
-         }
+      else if (myStrNCmp("-All", options[i], 2) == 0) {
+         if (doAll) return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         doAll = true;
       }
-      else if (thisGate)
-         return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
-      else
-         return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
-      if (checkLevel) {
-         if (++i == n)
-            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
-         if (!myStr2Int(options[i], level) || level < 0)
+      else if (userId < 0) {
+         if (!myStr2Int(options[i], userId) || userId < 0)
             return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
-         checkLevel = true;
       }
+      else return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
    }
-
-   if (!thisGate) {
-      cerr << "Error: Gate id is not specified!!" << endl;
+   if (userId < 0) {
+      cerr << "Error: user id is not specified!!" << endl;
       return CmdExec::errorOption(CMD_OPT_MISSING, options.back());
    }
 
-   if (doFanin)
-      thisGate->reportFanin(level);
-   else if (doFanout)
-      thisGate->reportFanout(level);
-   else
-      thisGate->reportGate();
+   if (movieId >= 0) {
+      double score;
+      if (!cirMgr->predict(userId, movieId, score)) {
+         cerr << "Error: (" << userId << ", " << movieId
+              << ") is out of range!!" << endl;
+         return CMD_EXEC_ERROR;
+      }
+      cout << "Predicted rating of movie " << movieId << " by user "
+           << userId << ": " << score << endl;
+      return CMD_EXEC_DONE;
+   }
+
+   ScoreList result;
+   if (!cirMgr->recommend(userId, k, result, !doAll)) {
+      cerr << "Error: user " << userId << " is out of range!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   cout << "Top " << result.size() << " movies for user " << userId << ":"
+        << endl;
+   for (size_t i = 0; i < result.size(); ++i)
+      cout << setw(4) << right << i+1 << ". movie " << setw(8) << left
+           << result[i]._movie << " score " << result[i]._score << endl;
 
    return CMD_EXEC_DONE;
 }
 
 void
-CirGateCmd::usage(ostream& os) const
+MatQueryCmd::usage(ostream& os) const
 {
-   os << "Usage: CIRGate <<(int gateId)> [<-FANIn | -FANOut><(int level)>]>"
-      << endl;
+   os << "Usage: MATQuery <(int userId)> [-K (int k) | -Movie (int movieId)]"
+      << " [-All]" << endl;
 }
 
 void
-CirGateCmd::help() const
+MatQueryCmd::help() const
 {
-   cout << setw(15) << left << "CIRGate: " << "report a gate\n";
+   cout << setw(15) << left << "MATQuery: "
+        << "recommend movies to a user from the trained factors\n";
 }
 
-
 //----------------------------------------------------------------------
-//    CIRWrite [-Output (string aagFile)]
+//    MATGenerate <(string fileName)> [-Users (int n)] [-Movies (int n)]
+//                [-Density (double d)] [-Latent (int r)] [-Alpha (double a)]
+//                [-Seed (int s)] [-Binary]
 //----------------------------------------------------------------------
 CmdExecStatus
-CirWriteCmd::exec(const string& option)
+MatGenerateCmd::exec(const string& option)
 {
-   if (!cirMgr) {
-      cerr << "Error: circuit is not yet constructed!!" << endl;
+   // check option
+   vector<string> options;
+   if (!CmdExec::lexOptions(option, options))
+      return CMD_EXEC_ERROR;
+   if (options.empty())
+      return CmdExec::errorOption(CMD_OPT_MISSING, "");
+
+   MatGenerator gen;
+   string fileName;
+   bool doUsers = false, doMovies = false, doLatent = false, doSeed = false;
+   bool doDensity = false, doAlpha = false;
+   for (size_t i = 0, n = options.size(); i < n; ++i) {
+      const string& opt = options[i];
+      if (myStrNCmp("-Binary", opt, 2) == 0) {
+         if (gen._binary) return CmdExec::errorOption(CMD_OPT_EXTRA, opt);
+         gen._binary = true;
+      }
+      else if (myStrNCmp("-Users", opt, 2) == 0 ||
+               myStrNCmp("-Movies", opt, 2) == 0 ||
+               myStrNCmp("-Latent", opt, 2) == 0 ||
+               myStrNCmp("-Seed", opt, 2) == 0) {
+         bool users = myStrNCmp("-Users", opt, 2) == 0;
+         bool movies = myStrNCmp("-Movies", opt, 2) == 0;
+         bool latent = myStrNCmp("-Latent", opt, 2) == 0;
+         bool& done = users ? doUsers : movies ? doMovies :
+                      latent ? doLatent : doSeed;
+         unsigned& value = users ? gen._users : movies ? gen._movies :
+                           latent ? gen._latent : gen._seed;
+         if (done) return CmdExec::errorOption(CMD_OPT_EXTRA, opt);
+         int num;
+         if (++i == n) return CmdExec::errorOption(CMD_OPT_MISSING, opt);
+         if (!myStr2Int(options[i], num) || num < 0)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         value = num;
+         done = true;
+      }
+      else if (myStrNCmp("-Density", opt, 2) == 0) {
+         if (doDensity) return CmdExec::errorOption(CMD_OPT_EXTRA, opt);
+         if (++i == n) return CmdExec::errorOption(CMD_OPT_MISSING, opt);
+         if (!myStr2Double(options[i], gen._density) || gen._density <= 0
+             || gen._density > 1)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doDensity = true;
+      }
+      else if (myStrNCmp("-Alpha", opt, 2) == 0) {
+         if (doAlpha) return CmdExec::errorOption(CMD_OPT_EXTRA, opt);
+         if (++i == n) return CmdExec::errorOption(CMD_OPT_MISSING, opt);
+         if (!myStr2Double(options[i], gen._alpha) || gen._alpha < 0)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doAlpha = true;
+      }
+      else {
+         if (fileName.size())
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, opt);
+         fileName = opt;
+      }
+   }
+   if (fileName.empty())
+      return CmdExec::errorOption(CMD_OPT_MISSING, "");
+   if (gen._users == 0 || gen._movies == 0 || gen._latent == 0) {
+      cerr << "Error: users, movies and latent must be positive!!" << endl;
       return CMD_EXEC_ERROR;
    }
+
+   if (!gen.generate(fileName))
+      return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, fileName);
+   cout << gen.getRatings() << " ratings of " << gen._users << " users and "
+        << gen._movies << " movies are written to \"" << fileName << "\""
+        << endl;
+
+   return CMD_EXEC_DONE;
+}
+
+void
+MatGenerateCmd::usage(ostream& os) const
+{
+   os << "Usage: MATGenerate <(string fileName)> [-Users (int n)] "
+      << "[-Movies (int n)]" << endl
+      << "                   [-Density (double d)] [-Latent (int r)] "
+      << "[-Alpha (double a)]" << endl
+      << "                   [-Seed (int s)] [-Binary]" << endl;
+}
+
+void
+MatGenerateCmd::help() const
+{
+   cout << setw(15) << left << "MATGenerate: "
+        << "write a synthetic rating dataset\n";
+}
+
+//----------------------------------------------------------------------
+//    MATUsage [-Phase | -Reset | -PErf <On | OFf>]
+//----------------------------------------------------------------------
+CmdExecStatus
+MatUsageCmd::exec(const string& option)
+{
    // check option
    vector<string> options;
-   CmdExec::lexOptions(option, options);
+   if (!CmdExec::lexOptions(option, options))
+      return CMD_EXEC_ERROR;
 
-   if (options.empty())
-      cirMgr->writeAag(cout);
-   else if (myStrNCmp("-Output", options[0], 2) == 0) {
+   if (options.empty()) {
+      myUsage.report(true, true);
+      cout << endl;
+      myUsage.reportPhases();
+   }
+   else if (myStrNCmp("-Phase", options[0], 2) == 0) {
+      if (options.size() > 1)
+         return CmdExec::errorOption(CMD_OPT_EXTRA, options[1]);
+      myUsage.reportPhases();
+   }
+   else if (myStrNCmp("-Reset", options[0], 2) == 0) {
+      if (options.size() > 1)
+         return CmdExec::errorOption(CMD_OPT_EXTRA, options[1]);
+      myUsage.resetPhases();
+   }
+   else if (myStrNCmp("-PErf", options[0], 3) == 0) {
       if (options.size() == 1)
          return CmdExec::errorOption(CMD_OPT_MISSING, options[0]);
       if (options.size() > 2)
          return CmdExec::errorOption(CMD_OPT_EXTRA, options[2]);
-      ofstream outfile(options[1].c_str(), ios::out);
-      if (!outfile)
-         return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, options[1]);
-      cirMgr->writeAag(outfile);
+      if (myStrNCmp("On", options[1], 2) == 0) {
+         if (!myUsage.enablePerf(true)) {
+            cerr << "Error: hardware counters are not available!!" << endl;
+            return CMD_EXEC_ERROR;
+         }
+      }
+      else if (myStrNCmp("OFf", options[1], 2) == 0)
+         myUsage.enablePerf(false);
+      else return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[1]);
    }
    else return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[0]);
 
@@ -313,15 +626,876 @@ CirWriteCmd::exec(const string& option)
 }
 
 void
-CirWriteCmd::usage(ostream& os) const
+MatUsageCmd::usage(ostream& os) const
 {
-   os << "Usage: CIRWrite [-Output (string aagFile)]" << endl;
+   os << "Usage: MATUsage [-Phase | -Reset | -PErf <On | OFf>]" << endl;
 }
 
 void
-CirWriteCmd::help() const
+MatUsageCmd::help() const
 {
-   cout << setw(15) << left << "CIRWrite: "
-        << "write the netlist to an ASCII AIG file (.aag)\n";
+   cout << setw(15) << left << "MATUsage: "
+        << "report the time used by each phase\n";
+}
+
+//----------------------------------------------------------------------
+//    MATSTReam <(string feed) | -> [-Size (int batch)] [-Follow]
+//              [-Publish (string file) [-Every (int events)]] [-Background]
+//----------------------------------------------------------------------
+CmdExecStatus
+MatStreamCmd::exec(const string& option)
+{
+   if (!cirMgr) {
+      cerr << "Error: mattrix is not yet constructed!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   if (cirMgr->isTraining()) {
+      cerr << "Error: training is in progress (see MATSTOp)!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   if (!cirMgr->isTrained()) {
+      cerr << "Error: mattrix is not yet trained!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   // check option
+   vector<string> options;
+   if (!CmdExec::lexOptions(option, options))
+      return CMD_EXEC_ERROR;
+
+   bool doBatch = false, doFollow = false, doEvery = false;
+   bool doBackground = false;
+   int batch = 256, every = 100000;
+   string feed, publishFile;
+   for (size_t i = 0, n = options.size(); i < n; ++i) {
+      if (myStrNCmp("-Size", options[i], 2) == 0) {
+         if (doBatch) return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Int(options[i], batch) || batch < 1)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doBatch = true;
+      }
+      else if (myStrNCmp("-Follow", options[i], 2) == 0) {
+         if (doFollow) return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         doFollow = true;
+      }
+      else if (myStrNCmp("-Publish", options[i], 2) == 0) {
+         if (publishFile.size())
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         publishFile = options[i];
+      }
+      else if (myStrNCmp("-Every", options[i], 2) == 0) {
+         if (doEvery) return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Int(options[i], every) || every < 1)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doEvery = true;
+      }
+      else if (myStrNCmp("-Background", options[i], 2) == 0) {
+         if (doBackground)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         doBackground = true;
+      }
+      else {
+         if (feed.size())
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         feed = options[i];
+      }
+   }
+   if (feed.empty())
+      return CmdExec::errorOption(CMD_OPT_MISSING, "");
+   if (doEvery && publishFile.empty())
+      return CmdExec::errorOption(CMD_OPT_MISSING, "-Publish");
+   // a followed feed never ends by itself
+   if (doFollow && !doBackground)
+      return CmdExec::errorOption(CMD_OPT_MISSING, "-Background");
+
+   cirMgr->setStream(batch, doFollow);
+   cirMgr->setPublish(publishFile, every);
+   if (doBackground) {
+      if (!cirMgr->streamBackground(feed)) return CMD_EXEC_ERROR;
+      cout << "Stream is started in background (see MATSTAtus)." << endl;
+   }
+   else if (!cirMgr->stream(feed)) return CMD_EXEC_ERROR;
+
+   return CMD_EXEC_DONE;
+}
+
+void
+MatStreamCmd::usage(ostream& os) const
+{
+   os << "Usage: MATSTReam <(string feed) | -> [-Size (int batch)] [-Follow]"
+      << endl
+      << "                 [-Publish (string file) [-Every (int events)]]"
+      << endl
+      << "                 [-Background]" << endl;
+}
+
+void
+MatStreamCmd::help() const
+{
+   cout << setw(15) << left << "MATSTReam: "
+        << "update the trained factors online from a rating feed\n";
+}
+
+//----------------------------------------------------------------------
+//    MATSTAtus
+//----------------------------------------------------------------------
+CmdExecStatus
+MatStatusCmd::exec(const string& option)
+{
+   string token;
+   if (!CmdExec::lexSingleOption(option, token))
+      return CMD_EXEC_ERROR;
+   if (!token.empty())
+      return CmdExec::errorOption(CMD_OPT_EXTRA, token);
+   if (!cirMgr) {
+      cerr << "Error: mattrix is not yet constructed!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   cirMgr->printStatus();
+
+   return CMD_EXEC_DONE;
+}
+
+void
+MatStatusCmd::usage(ostream& os) const
+{
+   os << "Usage: MATSTAtus" << endl;
+}
+
+void
+MatStatusCmd::help() const
+{
+   cout << setw(15) << left << "MATSTAtus: "
+        << "report the progress of matrix training\n";
+}
+
+//----------------------------------------------------------------------
+//    MATSTOp
+//----------------------------------------------------------------------
+CmdExecStatus
+MatStopCmd::exec(const string& option)
+{
+   string token;
+   if (!CmdExec::lexSingleOption(option, token))
+      return CMD_EXEC_ERROR;
+   if (!token.empty())
+      return CmdExec::errorOption(CMD_OPT_EXTRA, token);
+   if (!cirMgr || !cirMgr->stopTraining()) {
+      cerr << "Error: no training is in progress!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   cirMgr->printStatus();
+
+   return CMD_EXEC_DONE;
 }
 
+void
+MatStopCmd::usage(ostream& os) const
+{
+   os << "Usage: MATSTOp" << endl;
+}
+
+void
+MatStopCmd::help() const
+{
+   cout << setw(15) << left << "MATSTOp: "
+        << "stop background training and keep the best factors\n";
+}
+
+//----------------------------------------------------------------------
+//    MATCache [-Size (int MB)]
+//----------------------------------------------------------------------
+CmdExecStatus
+MatCacheCmd::exec(const string& option)
+{
+   if (!cirMgr) {
+      cerr << "Error: mattrix is not yet constructed!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   vector<string> options;
+   if (!CmdExec::lexOptions(option, options))
+      return CMD_EXEC_ERROR;
+
+   int size = -1;
+   for (size_t i = 0, n = options.size(); i < n; ++i) {
+      if (myStrNCmp("-Size", options[i], 2) == 0) {
+         if (size >= 0) return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Int(options[i], size) || size < 0)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+      }
+      else return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+   }
+   // a new size also empties the cache
+   if (size >= 0) cirMgr->setCacheSize(size_t(size) << 20);
+
+   MatCacheStats stats;
+   cirMgr->getCacheStats(stats);
+   cout << "Cache: " << stats._entries << " results, "
+        << stats._bytes / 1048576.0 << " of "
+        << cirMgr->getCacheSize() / 1048576.0 << " MB" << endl
+        << "Hits: " << stats._hits << ", misses: " << stats._misses
+        << ", hit rate: " << stats.hitRate() * 100 << "%, evictions: "
+        << stats._evictions << endl;
+
+   return CMD_EXEC_DONE;
+}
+
+void
+MatCacheCmd::usage(ostream& os) const
+{
+   os << "Usage: MATCache [-Size (int MB)]" << endl;
+}
+
+void
+MatCacheCmd::help() const
+{
+   cout << setw(15) << left << "MATCache: "
+        << "report or resize the cache of recommendations\n";
+}
+
+//----------------------------------------------------------------------
+//    MATSImilar <-Build [-N (int n)] [-Metric <Cosine | Dot>]
+//                       [-Threads (int n)]>
+//    MATSImilar <(int movieId)> [-K (int k)]
+//----------------------------------------------------------------------
+CmdExecStatus
+MatSimilarCmd::exec(const string& option)
+{
+   if (!cirMgr) {
+      cerr << "Error: mattrix is not yet constructed!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   if (!cirMgr->hasModel()) {
+      cerr << "Error: mattrix is not yet trained!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   vector<string> options;
+   if (!CmdExec::lexOptions(option, options))
+      return CMD_EXEC_ERROR;
+   if (options.empty())
+      return CmdExec::errorOption(CMD_OPT_MISSING, "");
+
+   bool doBuild = false, doMetric = false, cosine = true;
+   int n = -1, threads = -1, k = -1, movieId = -1;
+   string movieStr;
+   for (size_t i = 0, m = options.size(); i < m; ++i) {
+      if (myStrNCmp("-Build", options[i], 2) == 0) {
+         if (doBuild) return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         doBuild = true;
+      }
+      else if (myStrNCmp("-Metric", options[i], 2) == 0) {
+         if (doMetric) return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == m)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (myStrNCmp("Cosine", options[i], 1) == 0) cosine = true;
+         else if (myStrNCmp("Dot", options[i], 1) == 0) cosine = false;
+         else return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doMetric = true;
+      }
+      else if (myStrNCmp("-N", options[i], 2) == 0) {
+         if (n > 0) return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == m)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Int(options[i], n) || n <= 0)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+      }
+      else if (myStrNCmp("-Threads", options[i], 2) == 0) {
+         if (threads > 0)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == m)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Int(options[i], threads) || threads <= 0 ||
+             threads > MAT_RCU_POOL)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+      }
+      else if (myStrNCmp("-K", options[i], 2) == 0) {
+         if (k > 0) return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == m)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Int(options[i], k) || k <= 0)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+      }
+      else if (movieId < 0) {
+         if (!myStr2Int(options[i], movieId) || movieId < 0)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         movieStr = options[i];
+      }
+      else return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+   }
+
+   if (doBuild) {
+      if (movieId >= 0) return CmdExec::errorOption(CMD_OPT_EXTRA, movieStr);
+      if (k > 0) return CmdExec::errorOption(CMD_OPT_EXTRA, "-K");
+      if (n < 0) n = 20;
+      if (threads < 0)
+         threads = min(max(1, int(thread::hardware_concurrency())),
+                       MAT_RCU_POOL);
+      double start = myUsage.getWallTime();
+      cirMgr->buildSimilar(n, cosine, threads);
+      cout << "Neighbors built: " << n << " per movie by "
+           << (cosine ? "cosine" : "inner product") << ", " << threads
+           << " threads, " << myUsage.getWallTime() - start << " seconds"
+           << endl;
+      return CMD_EXEC_DONE;
+   }
+   if (doMetric || n > 0 || threads > 0) {
+      cerr << "Error: -N, -Metric and -Threads go with -Build!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   if (movieId < 0) {
+      cerr << "Error: movie id is not specified!!" << endl;
+      return CmdExec::errorOption(CMD_OPT_MISSING, options.back());
+   }
+   if (!cirMgr->hasSimilar()) {
+      cerr << "Error: neighbors are not yet built (see MATSImilar -Build)!!"
+           << endl;
+      return CMD_EXEC_ERROR;
+   }
+   ScoreList result;
+   if (!cirMgr->similar(movieId, k > 0 ? k : 10, result)) {
+      cerr << "Error: movie " << movieId << " is out of range!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   cout << "Top " << result.size() << " movies similar to movie " << movieId
+        << ":" << endl;
+   for (size_t i = 0; i < result.size(); ++i)
+      cout << setw(4) << right << i+1 << ". movie " << setw(8) << left
+           << result[i]._movie << " similarity " << result[i]._score << endl;
+
+   return CMD_EXEC_DONE;
+}
+
+void
+MatSimilarCmd::usage(ostream& os) const
+{
+   os << "Usage: MATSImilar <-Build [-N (int n)] [-Metric <Cosine | Dot>]"
+      << endl
+      << "                          [-Threads (int n)]>" << endl
+      << "       MATSImilar <(int movieId)> [-K (int k)]" << endl;
+}
+
+void
+MatSimilarCmd::help() const
+{
+   cout << setw(15) << left << "MATSImilar: "
+        << "build or look up the nearest neighbors of movies\n";
+}
+
+//----------------------------------------------------------------------
+//    CIRRead <(string fileName)> [-Replace]
+//----------------------------------------------------------------------
+CmdExecStatus
+CirReadCmd::exec(const string& option)
+{
+   // check option
+   vector<string> options;
+   if (!CmdExec::lexOptions(option, options))
+      return CMD_EXEC_ERROR;
+   if (options.empty())
+      return CmdExec::errorOption(CMD_OPT_MISSING, "");
+
+   bool doReplace = false;
+   string fileName;
+   for (size_t i = 0, n = options.size(); i < n; ++i) {
+      if (myStrNCmp("-Replace", options[i], 2) == 0) {
+         if (doReplace) return CmdExec::errorOption(CMD_OPT_EXTRA,options[i]);
+         doReplace = true;
+      }
+      else {
+         if (fileName.size())
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         fileName = options[i];
+      }
+   }
+
+   if (fileName.empty())
+      return CmdExec::errorOption(CMD_OPT_MISSING, "");
+   // the ratings and the model, if any, are kept
+   bool created = false;
+   if (cirMgr == 0) {
+      cirMgr = new CirMgr;
+      created = true;
+   }
+   else if (cirMgr->hasCircuit()) {
+      if (!doReplace) {
+         cerr << "Error: circuit already exists!!" << endl;
+         return CMD_EXEC_ERROR;
+      }
+      cerr << "Note: original circuit is replaced..." << endl;
+   }
+
+   if (!cirMgr->readCircuit(fileName)) {
+      if (created) {
+         curCmd = CIRINIT;
+         delete cirMgr; cirMgr = 0;
+      }
+      return CMD_EXEC_ERROR;
+   }
+
+   curCmd = CIRREAD;
+
+   return CMD_EXEC_DONE;
+}
+
+void
+CirReadCmd::usage(ostream& os) const
+{
+   os << "Usage: CIRRead <(string fileName)> [-Replace]" << endl;
+}
+
+void
+CirReadCmd::help() const
+{
+   cout << setw(15) << left << "CIRRead: "
+        << "read in a circuit and construct the netlist" << endl;
+}
+
+//----------------------------------------------------------------------
+//    CIRGate <<(int gateId)> [<-FANIn | -FANOut><(int level)>]>
+//----------------------------------------------------------------------
+CmdExecStatus
+CirGateCmd::exec(const string& option)
+{
+   if (!cirMgr) {
+      cerr << "Error: circuit has not been read!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+
+   // check option
+   vector<string> options;
+   if (!CmdExec::lexOptions(option, options))
+      return CMD_EXEC_ERROR;
+
+   if (options.empty())
+      return CmdExec::errorOption(CMD_OPT_MISSING, "");
+
+   int gateId = -1, level = 0;
+   bool doFanin = false, doFanout = false, found = false;
+   for (size_t i = 0, n = options.size(); i < n; ++i) {
+      bool checkLevel = false;
+      if (myStrNCmp("-FANIn", options[i], 5) == 0) {
+         if (doFanin || doFanout)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doFanin = true;
+         checkLevel = true;
+      }
+      else if (myStrNCmp("-FANOut", options[i], 5) == 0) {
+         if (doFanin || doFanout)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         doFanout = true;
+         checkLevel = true;
+      }
+      else if (!found) {
+         if (!myStr2Int(options[i], gateId) || gateId < 0)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         if (!cirMgr->hasGate(gateId)) {
+            cerr << "Error: Gate(" << gateId << ") not found!!" << endl;
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[0]);
+         }
+         found = true;
+      }
+      else if (found)
+         return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+      else
+         return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+      if (checkLevel) {
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         if (!myStr2Int(options[i], level) || level < 0)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         checkLevel = true;
+      }
+   }
+
+   if (!found) {
+      cerr << "Error: Gate id is not specified!!" << endl;
+      return CmdExec::errorOption(CMD_OPT_MISSING, options.back());
+   }
+
+   CirGate thisGate = cirMgr->getGate(gateId);
+   if (doFanin)
+      thisGate.reportFanin(level);
+   else if (doFanout)
+      thisGate.reportFanout(level);
+   else
+      thisGate.reportGate();
+
+   return CMD_EXEC_DONE;
+}
+
+void
+CirGateCmd::usage(ostream& os) const
+{
+   os << "Usage: CIRGate <<(int gateId)> [<-FANIn | -FANOut><(int level)>]>"
+      << endl;
+}
+
+void
+CirGateCmd::help() const
+{
+   cout << setw(15) << left << "CIRGate: " << "report a gate\n";
+}
+
+
+//----------------------------------------------------------------------
+//    CIRWrite [-Output (string aagFile | aigFile)]
+//----------------------------------------------------------------------
+CmdExecStatus
+CirWriteCmd::exec(const string& option)
+{
+   if (!cirMgr) {
+      cerr << "Error: circuit is not yet constructed!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   // check option
+   vector<string> options;
+   CmdExec::lexOptions(option, options);
+
+   if (options.empty())
+      cirMgr->writeAag(cout);
+   else if (myStrNCmp("-Output", options[0], 2) == 0) {
+      if (options.size() == 1)
+         return CmdExec::errorOption(CMD_OPT_MISSING, options[0]);
+      if (options.size() > 2)
+         return CmdExec::errorOption(CMD_OPT_EXTRA, options[2]);
+      const string& file = options[1];
+      bool binary = file.size() > 4 &&
+                    file.compare(file.size() - 4, 4, ".aig") == 0;
+      ofstream outfile(file.c_str(), ios::out | ios::binary);
+      if (!outfile)
+         return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, file);
+      if (!binary)
+         cirMgr->writeAag(outfile);
+      else if (!cirMgr->writeAig(outfile))
+         return CMD_EXEC_ERROR;
+   }
+   else return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[0]);
+
+   return CMD_EXEC_DONE;
+}
+
+void
+CirWriteCmd::usage(ostream& os) const
+{
+   os << "Usage: CIRWrite [-Output (string aagFile | aigFile)]" << endl;
+}
+
+void
+CirWriteCmd::help() const
+{
+   cout << setw(15) << left << "CIRWrite: "
+        << "write the netlist to an ASCII (.aag) or binary (.aig) AIG file\n";
+}
+
+
+//----------------------------------------------------------------------
+//    CIRCone <(unsigned gateId)>... [-FANOut]
+//            [-Output (string aagFile | aigFile)]
+//----------------------------------------------------------------------
+CmdExecStatus
+CirConeCmd::exec(const string& option)
+{
+   if (!cirMgr || !cirMgr->hasCircuit()) {
+      cerr << "Error: circuit is not yet constructed!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   // check option
+   vector<string> options;
+   if (!CmdExec::lexOptions(option, options))
+      return CMD_EXEC_ERROR;
+
+   IdList gates;
+   bool doFanout = false, doOutput = false;
+   string file;
+   for (size_t i = 0, n = options.size(); i < n; ++i) {
+      if (myStrNCmp("-FANOut", options[i], 5) == 0) {
+         if (doFanout) return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         doFanout = true;
+      }
+      else if (myStrNCmp("-Output", options[i], 2) == 0) {
+         if (doOutput) return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         file = options[i];
+         doOutput = true;
+      }
+      else {
+         int gateId;
+         if (!myStr2Int(options[i], gateId) || gateId < 0)
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         if (!cirMgr->hasGate(gateId)) {
+            cerr << "Error: Gate(" << gateId << ") not found!!" << endl;
+            return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+         }
+         gates.push_back(gateId);
+      }
+   }
+   if (gates.empty()) {
+      cerr << "Error: Gate id is not specified!!" << endl;
+      return CmdExec::errorOption(CMD_OPT_MISSING, "");
+   }
+
+   ofstream outfile;
+   bool binary = false;
+   if (doOutput) {
+      binary = file.size() > 4 && file.compare(file.size() - 4, 4, ".aig") == 0;
+      outfile.open(file.c_str(), ios::out | ios::binary);
+      if (!outfile)
+         return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, file);
+   }
+   CirMgr* cone = cirMgr->extractCone(gates, doFanout);
+   bool ok = true;
+   if (!doOutput) cone->writeAag(cout);
+   else if (!binary) cone->writeAag(outfile);
+   else ok = cone->writeAig(outfile);
+   delete cone;
+
+   return ok ? CMD_EXEC_DONE : CMD_EXEC_ERROR;
+}
+
+void
+CirConeCmd::usage(ostream& os) const
+{
+   os << "Usage: CIRCone <(unsigned gateId)>... [-FANOut]" << endl
+      << "               [-Output (string aagFile | aigFile)]" << endl;
+}
+
+void
+CirConeCmd::help() const
+{
+   cout << setw(15) << left << "CIRCone: "
+        << "write the fanin or fanout cone of gates as a circuit\n";
+}
+
+//----------------------------------------------------------------------
+//    CIRSIMulate <-Random | -File <string patternFile>>
+//                [-Output (string logFile)]
+//----------------------------------------------------------------------
+CmdExecStatus
+CirSimCmd::exec(const string& option)
+{
+   if (!cirMgr || !cirMgr->hasCircuit()) {
+      cerr << "Error: circuit is not yet constructed!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   // check option
+   vector<string> options;
+   CmdExec::lexOptions(option, options);
+
+   ifstream patternFile;
+   ofstream logFile;
+   bool doRandom = false, doFile = false, doLog = false;
+   for (size_t i = 0, n = options.size(); i < n; ++i) {
+      if (myStrNCmp("-Random", options[i], 2) == 0) {
+         if (doRandom || doFile)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         doRandom = true;
+      }
+      else if (myStrNCmp("-File", options[i], 2) == 0) {
+         if (doRandom || doFile)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         patternFile.open(options[i].c_str(), ios::in);
+         if (!patternFile)
+            return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, options[i]);
+         doFile = true;
+      }
+      else if (myStrNCmp("-Output", options[i], 2) == 0) {
+         if (doLog)
+            return CmdExec::errorOption(CMD_OPT_EXTRA, options[i]);
+         if (++i == n)
+            return CmdExec::errorOption(CMD_OPT_MISSING, options[i-1]);
+         logFile.open(options[i].c_str(), ios::out);
+         if (!logFile)
+            return CmdExec::errorOption(CMD_OPT_FOPEN_FAIL, options[i]);
+         doLog = true;
+      }
+      else
+         return CmdExec::errorOption(CMD_OPT_ILLEGAL, options[i]);
+   }
+
+   if (!doRandom && !doFile)
+      return CmdExec::errorOption(CMD_OPT_MISSING, "");
+
+   assert(curCmd != CIRINIT);
+   size_t patterns = 0;
+   cirMgr->setSimLog(doLog ? &logFile : 0);
+   if (doRandom)
+      patterns = cirMgr->randomSim();
+   else
+      cirMgr->fileSim(patternFile, patterns);
+   cirMgr->setSimLog(0);
+   cout << patterns << " patterns simulated." << endl;
+   curCmd = CIRSIMULATE;
+
+   return CMD_EXEC_DONE;
+}
+
+void
+CirSimCmd::usage(ostream& os) const
+{
+   os << "Usage: CIRSIMulate <-Random | -File <string patternFile>>\n"
+      << "                   [-Output (string logFile)]" << endl;
+}
+
+void
+CirSimCmd::help() const
+{
+   cout << setw(15) << left << "CIRSIMulate: "
+        << "perform Boolean logic simulation on the circuit\n";
+}
+
+//----------------------------------------------------------------------
+//    CIRSWeep
+//----------------------------------------------------------------------
+CmdExecStatus
+CirSweepCmd::exec(const string& option)
+{
+   if (!cirMgr || !cirMgr->hasCircuit()) {
+      cerr << "Error: circuit is not yet constructed!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   // check option
+   string token;
+   if (!CmdExec::lexSingleOption(option, token))
+      return CMD_EXEC_ERROR;
+   if (!token.empty())
+      return CmdExec::errorOption(CMD_OPT_EXTRA, token);
+
+   assert(curCmd != CIRINIT);
+   cout << "Sweeping: " << cirMgr->sweep() << " gate(s) removed." << endl;
+
+   return CMD_EXEC_DONE;
+}
+
+void
+CirSweepCmd::usage(ostream& os) const
+{
+   os << "Usage: CIRSWeep" << endl;
+}
+
+void
+CirSweepCmd::help() const
+{
+   cout << setw(15) << left << "CIRSWeep: "
+        << "remove unused gates\n";
+}
+
+//----------------------------------------------------------------------
+//    CIROPTimize
+//----------------------------------------------------------------------
+CmdExecStatus
+CirOptCmd::exec(const string& option)
+{
+   if (!cirMgr || !cirMgr->hasCircuit()) {
+      cerr << "Error: circuit is not yet constructed!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   // check option
+   string token;
+   if (!CmdExec::lexSingleOption(option, token))
+      return CMD_EXEC_ERROR;
+   if (!token.empty())
+      return CmdExec::errorOption(CMD_OPT_EXTRA, token);
+
+   assert(curCmd != CIRINIT);
+   cout << "Optimizing: " << cirMgr->optimize() << " gate(s) removed." << endl;
+   curCmd = CIROPT;
+
+   return CMD_EXEC_DONE;
+}
+
+void
+CirOptCmd::usage(ostream& os) const
+{
+   os << "Usage: CIROPTimize" << endl;
+}
+
+void
+CirOptCmd::help() const
+{
+   cout << setw(15) << left << "CIROPTimize: "
+        << "perform trivial optimizations\n";
+}
+
+//----------------------------------------------------------------------
+//    CIRSTRash
+//----------------------------------------------------------------------
+CmdExecStatus
+CirStrashCmd::exec(const string& option)
+{
+   if (!cirMgr || !cirMgr->hasCircuit()) {
+      cerr << "Error: circuit is not yet constructed!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   // check option
+   string token;
+   if (!CmdExec::lexSingleOption(option, token))
+      return CMD_EXEC_ERROR;
+   if (!token.empty())
+      return CmdExec::errorOption(CMD_OPT_EXTRA, token);
+
+   assert(curCmd != CIRINIT);
+   cout << "Strashing: " << cirMgr->strash() << " gate(s) removed." << endl;
+   curCmd = CIRSTRASH;
+
+   return CMD_EXEC_DONE;
+}
+
+void
+CirStrashCmd::usage(ostream& os) const
+{
+   os << "Usage: CIRSTRash" << endl;
+}
+
+void
+CirStrashCmd::help() const
+{
+   cout << setw(15) << left << "CIRSTRash: "
+        << "perform structural hash on the circuit netlist\n";
+}
+
+//----------------------------------------------------------------------
+//    CIRFraig
+//----------------------------------------------------------------------
+CmdExecStatus
+CirFraigCmd::exec(const string& option)
+{
+   if (!cirMgr || !cirMgr->hasCircuit()) {
+      cerr << "Error: circuit is not yet constructed!!" << endl;
+      return CMD_EXEC_ERROR;
+   }
+   // check option
+   string token;
+   if (!CmdExec::lexSingleOption(option, token))
+      return CMD_EXEC_ERROR;
+   if (!token.empty())
+      return CmdExec::errorOption(CMD_OPT_EXTRA, token);
+
+   assert(curCmd != CIRINIT);
+   cout << "Fraig: " << cirMgr->fraig() << " gate(s) removed." << endl;
+   curCmd = CIRFRAIG;
+
+   return CMD_EXEC_DONE;
+}
+
+void
+CirFraigCmd::usage(ostream& os) const
+{
+   os << "Usage: CIRFraig" << endl;
+}
+
+void
+CirFraigCmd::help() const
+{
+   cout << setw(15) << left << "CIRFraig: "
+        << "merge the gates proven equivalent by SAT\n";
+}
@@ -14,7 +14,22 @@
 CmdClass(MatReadCmd);
 CmdClass(MatPrintCmd);
 CmdClass(MatTrainCmd);
+CmdClass(MatQueryCmd);
+CmdClass(MatGenerateCmd);
+CmdClass(MatUsageCmd);
+CmdClass(MatStatusCmd);
+CmdClass(MatStopCmd);
+CmdClass(MatStreamCmd);
+CmdClass(MatCacheCmd);
+CmdClass(MatSimilarCmd);
+CmdClass(CirReadCmd);
 CmdClass(CirGateCmd);
 CmdClass(CirWriteCmd);
+CmdClass(CirConeCmd);
+CmdClass(CirSimCmd);
+CmdClass(CirSweepCmd);
+CmdClass(CirOptCmd);
+CmdClass(CirStrashCmd);
+CmdClass(CirFraigCmd);
 
 #endif // CIR_CMD_H
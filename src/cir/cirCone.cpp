@@ -0,0 +1,132 @@
+/****************************************************************************
+  FileName     [ cirCone.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define cir cone extraction functions ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <vector>
+#include <string>
+#include "cirMgr.h"
+#include "util.h"
+
+using namespace std;
+
+// The marks of extractCone(), apart from those of _aig
+enum ConeMark
+{
+   CONE_TFO     = 1,   // in the transitive fanout of the gates
+   CONE_VISITED = 2
+};
+
+/*********************************************/
+/*   Public member functions about the cone   */
+/*********************************************/
+// Both traversals are iterative, on marks of their own, so that _aig is
+// left as it is. A fanout cone keeps only the gates on a path to a PO.
+// A cut gate, or a gate given that is no PO, is named "n<id>" after its
+// id here.
+CirMgr*
+CirMgr::extractCone(const IdList& gates, bool fanout) const
+{
+    const IdList& piList = _aig.getPiList();
+    const IdList& poList = _aig.getPoList();
+    vector<unsigned char> mark(_aig.size(), 0);
+    IdList roots;   // of the POs of the cone
+    if (fanout) {
+        IdList stack;
+        for (size_t i = 0; i < gates.size(); ++i)
+            if (!mark[gates[i]]) {
+                mark[gates[i]] = CONE_TFO;
+                stack.push_back(gates[i]);
+            }
+        while (!stack.empty()) {
+            unsigned id = stack.back();
+            stack.pop_back();
+            for (const unsigned* f = _aig.fanoutBegin(id);
+                 f != _aig.fanoutEnd(id); ++f)
+                if (!mark[*f / 2]) {
+                    mark[*f / 2] = CONE_TFO;
+                    stack.push_back(*f / 2);
+                }
+        }
+        for (size_t i = 0; i < poList.size(); ++i)
+            if (mark[poList[i]]) roots.push_back(poList[i]);
+    }
+    else roots = gates;
+
+    // The AIGs inside, fanins first, as in dfs(); the other gates reached
+    // are the leaves
+    IdList aigs, leaves;
+    vector<pair<unsigned, int> > stack;
+    for (size_t r = 0; r < roots.size(); ++r) {
+        unsigned root = roots[r];
+        if (_aig.getType(root) == PO_GATE) root = _aig.getFanin(root, 0) / 2;
+        if (mark[root] & CONE_VISITED) continue;
+        mark[root] |= CONE_VISITED;
+        bool inside = _aig.getType(root) == AIG_GATE &&
+                      (!fanout || (mark[root] & CONE_TFO));
+        if (!inside) { leaves.push_back(root); continue; }
+        stack.push_back(make_pair(root, 0));
+        while (!stack.empty()) {
+            unsigned id = stack.back().first;
+            if (stack.back().second == 2) {
+                aigs.push_back(id);
+                stack.pop_back();
+                continue;
+            }
+            unsigned in = _aig.getFanin(id, stack.back().second++) / 2;
+            if (mark[in] & CONE_VISITED) continue;
+            mark[in] |= CONE_VISITED;
+            if (_aig.getType(in) == AIG_GATE && (!fanout || (mark[in] & CONE_TFO)))
+                stack.push_back(make_pair(in, 0));
+            else leaves.push_back(in);
+        }
+    }
+
+    // PIs 1..I, the original ones first, then the AIGs and the UNDEF gates
+    IdList newId(_aig.size(), 0), pis, undefs;
+    for (size_t i = 0; i < piList.size(); ++i)
+        if (mark[piList[i]] & CONE_VISITED) pis.push_back(piList[i]);
+    for (size_t i = 0; i < leaves.size(); ++i) {
+        GateType type = _aig.getType(leaves[i]);
+        if (type == AIG_GATE) pis.push_back(leaves[i]);
+        else if (type == UNDEF_GATE) undefs.push_back(leaves[i]);
+    }
+    unsigned n = 0;
+    for (size_t i = 0; i < pis.size(); ++i) newId[pis[i]] = ++n;
+    for (size_t i = 0; i < aigs.size(); ++i) newId[aigs[i]] = ++n;
+    for (size_t i = 0; i < undefs.size(); ++i) newId[undefs[i]] = ++n;
+
+    CirMgr* cone = new CirMgr;
+    cone->_max = n;
+    cone->_pis = pis.size();
+    cone->_pos = roots.size();
+    cone->_aigs = aigs.size();
+    cone->_aig.reset(n + roots.size() + 1);
+    for (size_t i = 0; i < pis.size(); ++i) {
+        cone->_aig.setPi(newId[pis[i]], 0);
+        string sym = _aig.getType(pis[i]) == PI_GATE ?
+                     _aig.getSymbol(pis[i]) : "n" + to_string(pis[i]);
+        if (!sym.empty()) cone->_aig.setSymbol(newId[pis[i]], sym);
+    }
+    for (size_t i = 0; i < aigs.size(); ++i) {
+        unsigned in0 = _aig.getFanin(aigs[i], 0), in1 = _aig.getFanin(aigs[i], 1);
+        cone->_aig.setAig(newId[aigs[i]], 0, 2 * newId[in0 / 2] + (in0 & 1),
+                          2 * newId[in1 / 2] + (in1 & 1));
+    }
+    for (size_t i = 0; i < roots.size(); ++i) {
+        unsigned id = n + 1 + i, lit = 2 * roots[i];
+        string sym = "n" + to_string(roots[i]);
+        if (_aig.getType(roots[i]) == PO_GATE) {
+            lit = _aig.getFanin(roots[i], 0);
+            sym = _aig.getSymbol(roots[i]);
+        }
+        if (!sym.empty()) cone->_aig.setSymbol(id, sym);
+        cone->_aig.setPo(id, 0, 2 * newId[lit / 2] + (lit & 1));
+    }
+    cone->_aig.buildFanouts();
+    cone->traversal();
+    return cone;
+}
@@ -15,9 +15,27 @@ using namespace std;
 
 class CirGate;
 class CirMgr;
+struct MatCkpt;
+class MatInput;
+class SatSolver;
+
+struct Rating
+{
+   unsigned _user;
+   unsigned _movie;
+   float    _rating;
+};
+
+struct MovieScore
+{
+   unsigned _movie;
+   double   _score;
+};
 
 typedef vector<CirGate*>           GateList;
 typedef vector<unsigned>           IdList;
+typedef vector<Rating>             RatingList;
+typedef vector<MovieScore>         ScoreList;
 
 enum GateType
 {
@@ -30,4 +48,24 @@ enum GateType
    TOT_GATE
 };
 
+// Order in which the ratings are visited in one SGD epoch
+enum MatOrderType
+{
+   ORDER_USER    = 0,  // user-major, movie-ascending (the file order)
+   ORDER_SHUFFLE = 1,  // full random permutation per epoch
+   ORDER_BLOCK   = 2,  // shuffled cache-sized user x movie tiles
+   ORDER_HILBERT = 3,  // Hilbert curve over the user x movie grid
+
+   ORDER_TOT
+};
+
+// How MATTrain holds out the validation ratings
+enum MatSplitType
+{
+   SPLIT_RANDOM,    // each rating with probability _validRatio
+   SPLIT_TIME,      // the latest _validRatio of the ratings
+
+   SPLIT_TOT
+};
+
 #endif // CIR_DEF_H
@@ -0,0 +1,286 @@
+/****************************************************************************
+  FileName     [ cirFraig.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define cir FRAIG functions ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <vector>
+#include <algorithm>
+#include <climits>
+#include "cirMgr.h"
+#include "cirSat.h"
+#include "rnGen.h"
+#include "util.h"
+
+using namespace std;
+
+// Conflicts a SAT call may take before its pair is given up
+#define CIR_FRAIG_CONFLICTS  1000
+// The solver starts over when its vars outnumber those of the two cones
+// of a call this many times, and CIR_FRAIG_MIN_VARS
+#define CIR_FRAIG_REBUILD    4
+#define CIR_FRAIG_MIN_VARS   8192
+
+/**************************************/
+/*   Static varaibles and functions   */
+/**************************************/
+// Literals by the position of their gates in _netList
+struct FraigOrder
+{
+    const IdList* _order;
+    bool operator() (unsigned a, unsigned b) const {
+        return (*_order)[a / 2] < (*_order)[b / 2];
+    }
+};
+
+// Open-addressing table of AIGs keyed on their fanins, the smaller
+// literal first. Id 0, never an AIG, marks an empty slot.
+class StrashTable
+{
+public:
+    StrashTable(size_t n) {
+        size_t size = 16;
+        while (size < 2 * n) size *= 2;
+        _slots.assign(size, StrashSlot());
+        _mask = size - 1;
+    }
+
+    // The AIG already in the table with fanins "lit0" and "lit1", or "id"
+    // after it is added
+    unsigned insert(unsigned lit0, unsigned lit1, unsigned id) {
+        if (lit0 > lit1) { unsigned t = lit0; lit0 = lit1; lit1 = t; }
+        unsigned long long key = (unsigned long long)lit0 << 32 | lit1;
+        size_t i = size_t((key * 0x9e3779b97f4a7c15ULL) >> 32) & _mask;
+        for (; _slots[i]._id != 0; i = (i + 1) & _mask)
+            if (_slots[i]._key == key) return _slots[i]._id;
+        _slots[i]._key = key;
+        _slots[i]._id = id;
+        return id;
+    }
+
+private:
+    struct StrashSlot {
+        StrashSlot() : _key(0), _id(0) {}
+        unsigned long long _key;
+        unsigned           _id;
+    };
+    vector<StrashSlot>  _slots;
+    size_t              _mask;
+};
+
+/*******************************************/
+/*   Public member functions about fraig   */
+/*******************************************/
+// AIGs of _netList are visited fanins first, so the fanins of an AIG are
+// final when it is hashed. A duplicate is merged into the AIG that was
+// hashed first: its fanouts, whatever their reach, are rewired to it.
+unsigned
+CirMgr::strash()
+{
+    StrashTable table(_aig.getAigList().size());
+    unsigned removed = 0;
+    for (size_t i = 0; i < _netList.size(); ++i) {
+        unsigned id = _netList[i];
+        if (_aig.getType(id) != AIG_GATE) continue;
+        unsigned keep = table.insert(_aig.getFanin(id, 0),
+                                     _aig.getFanin(id, 1), id);
+        if (keep == id) continue;
+        mergeGate(id, 2 * keep);
+        ++removed;
+    }
+    if (removed) {
+        _aigs -= removed;
+        _aig.buildFanouts();
+        traversal();
+        resetSim();
+    }
+    return removed;
+}
+
+// Prove each FEC candidate against the first gate of its group in
+// _netList order. A proven gate is merged into it, which cannot make a
+// cycle. The candidates are taken in _netList order too: with their
+// fanins merged, most proofs are short. A counterexample becomes a
+// pattern of the next simulation pass, which splits the pair and any
+// other pair it tells apart. The cones are encoded into one solver as
+// they are first needed; as every call propagates through all of it, the
+// solver starts over once it is much larger than the cones in question.
+// Ends with strash(); returns the AIGs removed in all.
+unsigned
+CirMgr::fraig()
+{
+    if (!_fecInit) randomSim();
+    IdList ops;
+    buildSimOps(ops);   // the groups are kept
+
+    IdList order(_aig.size(), UINT_MAX);
+    order[0] = 0;
+    for (size_t i = 0; i < _netList.size(); ++i) order[_netList[i]] = i + 1;
+    FraigOrder byOrder = { &order };
+
+    const IdList& pis = _aig.getPiList();
+    SatSolver solver;
+    IdList vars(_aig.size(), 0);   // solver var + 1 of a gate, if encoded
+    // literal a candidate is proven against; UINT_MAX - 1 once it is done
+    IdList rep(_aig.size(), UINT_MAX);
+    vector<SatLit> assump(1);
+    IdList cone;
+    unsigned merged = 0, patterns = 0;
+    while (!_fecGrps.empty()) {
+        for (size_t g = 0; g < _fecGrps.size(); ++g) {
+            IdList& grp = _fecGrps[g];
+            sort(grp.begin(), grp.end(), byOrder);
+            for (size_t i = 1; i < grp.size(); ++i)
+                rep[grp[i] / 2] = grp[0] ^ (grp[i] & 1);
+        }
+        // the counterexamples overwrite the first patterns; a pass of them
+        // alone may show a pair as complementary instead of splitting it
+        randomPis();
+        // the candidates in _netList order, so that their fanins are
+        // merged before them
+        for (size_t n = 0; n < _netList.size(); ++n) {
+            unsigned id = _netList[n];
+            if (rep[id] == UINT_MAX) continue;
+            if (patterns == CIR_SIM_WORDS * 64) break;
+            SatLit a, b;
+            for (;;) {
+                a = satLit(solver, vars, rep[id]);
+                b = satLit(solver, vars, 2 * id);
+                cone.clear();
+                _aig.newMark();
+                satCone(vars, rep[id] / 2, cone);
+                satCone(vars, id, cone);
+                unsigned size = solver.getNumVars();
+                if (size <= CIR_FRAIG_MIN_VARS || size <= CIR_FRAIG_REBUILD * cone.size())
+                    break;
+                solver.reset();   // then only the two cones are encoded
+                vars.assign(vars.size(), 0);
+            }
+            SatLit x = 2 * solver.newVar(false);
+            solver.addXor(x, a, b);
+            assump[0] = x;
+            // only the two cones are decided; the rest of the solver
+            // follows or stays unassigned
+            for (size_t c = 0; c < cone.size(); ++c)
+                solver.setDecision(cone[c], true);
+            SatStatus status = solver.solve(assump, CIR_FRAIG_CONFLICTS);
+            for (size_t c = 0; c < cone.size(); ++c)
+                solver.setDecision(cone[c], false);
+            if (status == SAT_UNSAT) {
+                solver.addClause(x ^ 1);
+                mergeGate(id, rep[id]);
+                ++merged;
+            }
+            else if (status == SAT_SAT) {
+                for (size_t p = 0; p < pis.size(); ++p) {
+                    unsigned v = vars[pis[p]];
+                    unsigned char val = v ? solver.getValue(v - 1) : 2;
+                    unsigned long long bit = val == 2 ? my_random() & 1 : val;
+                    unsigned long long& w =
+                        _simValue[size_t(pis[p]) * CIR_SIM_WORDS + patterns / 64];
+                    w = (w & ~(1ULL << (patterns % 64))) | bit << (patterns % 64);
+                }
+                ++patterns;
+                continue;   // kept for the next pass
+            }
+            rep[id] = UINT_MAX - 1;   // merged, or given up
+        }
+        // the candidates left, and those not reached, stay in their groups
+        vector<IdList> grps;
+        for (size_t g = 0; g < _fecGrps.size(); ++g) {
+            const IdList& grp = _fecGrps[g];
+            IdList left(1, grp[0]);
+            for (size_t i = 1; i < grp.size(); ++i) {
+                if (rep[grp[i] / 2] != UINT_MAX - 1) left.push_back(grp[i]);
+                rep[grp[i] / 2] = UINT_MAX;
+            }
+            if (left.size() > 1) grps.push_back(left);
+        }
+        _fecGrps.swap(grps);
+        if (patterns == 0) break;
+        simPass(ops, CIR_SIM_WORDS * 64);
+        patterns = 0;
+    }
+
+    if (merged) {
+        _aigs -= merged;
+        _aig.buildFanouts();
+        traversal();
+    }
+    resetSim();
+    return merged + strash();
+}
+
+/********************************************/
+/*   Private member functions about fraig   */
+/********************************************/
+// Rewire the fanouts of AIG "id" to "lit", and remove it. Its fanouts
+// are those of the last buildFanouts(), as "id" is never a merge target.
+void
+CirMgr::mergeGate(unsigned id, unsigned lit)
+{
+    for (const unsigned* f = _aig.fanoutBegin(id); f != _aig.fanoutEnd(id); ++f) {
+        unsigned out = *f / 2;
+        GateType type = _aig.getType(out);
+        if (type == UNDEF_GATE) continue;   // merged already
+        int fanins = type == PO_GATE ? 1 : 2;
+        for (int j = 0; j < fanins; ++j) {
+            unsigned in = _aig.getFanin(out, j);
+            if (in / 2 == id) _aig.setFanin(out, j, lit ^ (in & 1));
+        }
+    }
+    _aig.removeAig(id);
+}
+
+// The solver literal of AIG literal "lit", after the Tseitin clauses of
+// its cone. CONST 0 and UNDEF gates are false, PIs are free.
+SatLit
+CirMgr::satLit(SatSolver& solver, IdList& vars, unsigned lit)
+{
+    IdList stack(1, lit / 2);
+    while (!stack.empty()) {
+        unsigned id = stack.back();
+        if (vars[id]) { stack.pop_back(); continue; }
+        GateType type = _aig.getType(id);
+        if (type != AIG_GATE) {
+            unsigned v = solver.newVar(false);
+            if (type != PI_GATE) solver.addClause(2 * v + 1);
+            vars[id] = v + 1;
+            stack.pop_back();
+            continue;
+        }
+        unsigned in0 = _aig.getFanin(id, 0), in1 = _aig.getFanin(id, 1);
+        if (!vars[in0 / 2]) { stack.push_back(in0 / 2); continue; }
+        if (!vars[in1 / 2]) { stack.push_back(in1 / 2); continue; }
+        unsigned v = solver.newVar(false);
+        solver.addAnd(2 * v, 2 * (vars[in0 / 2] - 1) + (in0 & 1),
+                      2 * (vars[in1 / 2] - 1) + (in1 & 1));
+        vars[id] = v + 1;
+        stack.pop_back();
+    }
+    return 2 * (vars[lit / 2] - 1) + (lit & 1);
+}
+
+// Append the solver vars of the unmarked gates of the cone of "id", all
+// of them encoded by satLit()
+void
+CirMgr::satCone(const IdList& vars, unsigned id, IdList& cone) const
+{
+    if (_aig.isMarked(id)) return;
+    IdList stack(1, id);
+    _aig.setMark(id);
+    while (!stack.empty()) {
+        id = stack.back();
+        stack.pop_back();
+        cone.push_back(vars[id] - 1);
+        if (_aig.getType(id) != AIG_GATE) continue;
+        for (int i = 0; i < 2; ++i) {
+            unsigned in = _aig.getFanin(id, i) / 2;
+            if (_aig.isMarked(in)) continue;
+            _aig.setMark(in);
+            stack.push_back(in);
+        }
+    }
+}
@@ -17,244 +17,134 @@
 
 using namespace std;
 
-extern CirMgr *cirMgr;
-extern unsigned GlobalMark;
-
-static int GlobalLevel = -1;
-
-// TODO: Implement memeber functions for class(es) in cirGate.h
-
 /**************************************/
 /*   class CirGate member functions   */
 /**************************************/
-void
-PiGate::printGate() const {
-    cout << "PI  " << getID();
-    if (!_symbol.empty()) cout << " (" << _symbol << ')';
-    cout << endl;
-}
-
-void
-PiGate::reportGate() const{
-    stringstream ss;
-    ss << _id << ' ' << _line+1;
-    string id, line;
-    ss >> id >> line;
-    cout << "==================================================" << endl;
-    if (_symbol.empty()) {
-        string print = "= PI(" + id + "), line " + line;
-        cout << setw(48) << left << print << " =" << endl;
-    }
-    else {
-        string print = "= PI(" + id + ")\"" + _symbol + "\", line " + line;
-        cout << setw(48) << left << print << " =" << endl;
-    }
-    cout << "==================================================" << endl;
-}
-
-void
-PiGate::reportFanin(int level) {
-    assert (level >= 0);
-    cout << "PI " << getID() << endl;
-}
-
-void
-PiGate::reportFanout(int level) {
-    assert (level >= 0);
-    if (GlobalLevel < 0) { GlobalLevel = level; GlobalMark++; }
-    cout << "PI " << getID() << endl;
-    if (level != 0) {
-        for (unsigned i = 0; i < _outList.size(); i++) {
-            cout << "  ";
-            if (_invList[i]) cout << '!';
-            _outList[i]->reportFanout(level-1);
-        }
-    }
-    if (GlobalLevel == level) GlobalLevel = -1;
-}
-
-void
-PiGate::dfs() {}
-
-void
-PoGate::printGate() const {
-    cout << "PO  " << getID() << ' ';
-    if (_in->checkUndef()) cout << '*';
-    if (_inv) cout << '!';
-    cout << _in->getID();
-    if (!_symbol.empty()) cout << " (" << _symbol << ')';
-    cout << endl;
-}
-
-void
-PoGate::reportGate() const{
-    stringstream ss;
-    ss << _id << ' ' << _line+1;
-    string id, line;
-    ss >> id >> line;
-    cout << "==================================================" << endl;
-    if (_symbol.empty()) {
-        string print = "= PO(" + id + "), line " + line;
-        cout << setw(48) << left << print << " =" << endl;
-    }
-    else {
-        string print = "= PO(" + id + ")\"" + _symbol + "\", line " + line;
-        cout << setw(48) << left << print << " =" << endl;
-    }
-    cout << "==================================================" << endl;
-}
-
-void
-PoGate::reportFanin(int level) {
-    assert (level >= 0);
-    if (GlobalLevel < 0) { GlobalLevel = level; GlobalMark++; }
-    cout << "PO " << getID() << endl;
-    if (level != 0) {
-        cout << "  ";
-        if (_inv) cout << '!';
-        _in->reportFanin(level-1);
-    }
-    if (GlobalLevel == level) GlobalLevel = -1;
-}
-
-void
-PoGate::reportFanout(int level) {
-    assert (level >= 0);
-    cout << "PO " << getID() << endl;
-}
-
-void
-PoGate::dfs(){
-    if ((_in->getMark() == GlobalMark)) return;
-    _in->setMark();
-    if (!(_in->checkUndef())) { _in->dfs(); cirMgr->setNet(_in);}
-}
-
-void
-AigGate::printGate() const {
-    cout << "AIG " << getID() << ' ';
-    if (_in1->checkUndef()) cout << '*';
-    if (_inv1) cout << '!';
-    cout << _in1->getID() << ' ';
-
-    if (_in2->checkUndef()) cout << '*';
-    if (_inv2) cout << '!';
-    cout << _in2->getID();
-    if (!_symbol.empty()) cout << " (" << _symbol << ')';
-    cout << endl;
-}
-
-void
-AigGate::reportGate() const{
-    stringstream ss;
-    ss << _id << ' ' << _line+1;
-    string id, line;
-    ss >> id >> line;
-    cout << "==================================================" << endl;
-    if (checkUndef()) {
-        string print = "= UNDEF(" + id + "), line 0";
-        cout << setw(48) << left << print << " =" << endl;
-    }
-    else {
-        string print = "= AIG(" + id + "), line " + line;
-        cout << setw(48) << left << print << " =" << endl;
-    }
-    cout << "==================================================" << endl;
-}
-
-void
-AigGate::reportFanin(int level) {
-    assert (level >= 0);
-    if (GlobalLevel < 0) { GlobalLevel = level; GlobalMark++; }
-    if (checkUndef()) cout << "UNDEF " << getID() << endl;
-    else {
-        cout << "AIG " << getID();
-        if (level != 0) {
-            if (_mark == GlobalMark) cout << " (*)" << endl;
-            else {
-                cout << endl;
-                setMark();
-                for(int j = 0; j <= GlobalLevel-level; j++) cout << "  ";
-                if (_inv1) cout << '!';
-                _in1->reportFanin(level-1);
-
-                for(int j = 0; j <= GlobalLevel-level; j++) cout << "  ";
-                if (_inv2) cout << '!';
-                _in2->reportFanin(level-1);
-            }
-        }
-        else cout << endl;
-    }
-    if (GlobalLevel == level) GlobalLevel = -1;
-}
-
-void
-AigGate::reportFanout(int level) {
-    assert (level >= 0);
-    if (GlobalLevel < 0) { GlobalLevel = level; GlobalMark++; }
-    cout << "AIG " << getID();
-    if (level != 0) {
-        if (_mark == GlobalMark) cout << " (*)" << endl;
-        else if (!_outList.empty()) {
-            cout << endl;
-            setMark();
-            for (unsigned i = 0; i < _outList.size(); i++) {
-                for(int j = 0; j <= GlobalLevel-level; j++) cout << "  ";
-                if (_invList[i]) cout << '!';
-                _outList[i]->reportFanout(level-1);
-            }
-        }
-        else cout << endl;
-    }
-    else cout << endl;
-    if (GlobalLevel == level) GlobalLevel = -1;
-}
-
-void
-AigGate::dfs(){
-    if (!(_in1->getMark() == GlobalMark)) {
-        _in1->setMark();
-        if (!(_in1->checkUndef())) { _in1->dfs(); cirMgr->setNet(_in1); }
-    }
-    if (!(_in2->getMark() == GlobalMark)) {
-        _in2->setMark();
-        if (!(_in2->checkUndef())) { _in2->dfs(); cirMgr->setNet(_in2); }
-    }
+string
+CirGate::getTypeStr() const
+{
+   switch (getType()) {
+      case PI_GATE:    return "PI";
+      case PO_GATE:    return "PO";
+      case AIG_GATE:   return "AIG";
+      case CONST_GATE: return "CONST";
+      default:         return "UNDEF";
+   }
+}
+
+bool
+CirGate::checkFloat() const
+{
+   switch (getType()) {
+      case PO_GATE:
+         return _aig->getType(linkValue() / 2) == UNDEF_GATE;
+      case AIG_GATE:
+         return _aig->getType(linkValue() / 2) == UNDEF_GATE ||
+                _aig->getType(linkValue(false) / 2) == UNDEF_GATE;
+      default:
+         return false;
+   }
+}
+
+bool
+CirGate::checkUnused() const
+{
+   GateType type = getType();
+   return (type == PI_GATE || type == AIG_GATE || type == CONST_GATE) &&
+          _aig->getFanoutNum(_id) == 0;
+}
+
+void
+CirGate::printGate() const
+{
+   GateType type = getType();
+   if (type == CONST_GATE) { cout << "CONST0" << endl; return; }
+   cout << setw(4) << left << getTypeStr() << _id;
+   int fanins = type == PO_GATE ? 1 : type == AIG_GATE ? 2 : 0;
+   for (int i = 0; i < fanins; ++i) {
+      unsigned lit = _aig->getFanin(_id, i);
+      cout << ' ';
+      if (_aig->getType(lit / 2) == UNDEF_GATE) cout << '*';
+      if (lit & 1) cout << '!';
+      cout << lit / 2;
+   }
+   if (!getSymbol().empty()) cout << " (" << getSymbol() << ')';
+   cout << endl;
+}
+
+void
+CirGate::reportGate() const
+{
+   GateType type = getType();
+   stringstream ss;
+   ss << "= " << getTypeStr() << '(' << _id << ')';
+   if ((type == PI_GATE || type == PO_GATE) && !getSymbol().empty())
+      ss << '"' << getSymbol() << '"';
+   ss << ", line "
+      << (type == UNDEF_GATE || type == CONST_GATE ? 0 : getLineNo() + 1);
+   cout << "==================================================" << endl;
+   cout << setw(48) << left << ss.str() << " =" << endl;
+   cout << "==================================================" << endl;
+}
+
+void
+CirGate::reportFanin(int level) const
+{
+   assert (level >= 0);
+   _aig->newMark();
+   reportFanin(level, 0);
+}
+
+// An AIG is expanded once per report; (*) marks a repeated one
+void
+CirGate::reportFanin(int level, int indent) const
+{
+   GateType type = getType();
+   if (type == CONST_GATE) { cout << "CONST 0" << endl; return; }
+   cout << getTypeStr() << ' ' << _id;
+   if (level == 0 || (type != PO_GATE && type != AIG_GATE)) {
+      cout << endl;
+      return;
+   }
+   if (type == AIG_GATE) {
+      if (_aig->isMarked(_id)) { cout << " (*)" << endl; return; }
+      _aig->setMark(_id);
+   }
+   cout << endl;
+   for (int i = 0; i < (type == AIG_GATE ? 2 : 1); ++i) {
+      unsigned lit = _aig->getFanin(_id, i);
+      cout << string(2 * (indent + 1), ' ');
+      if (lit & 1) cout << '!';
+      CirGate(_aig, lit / 2).reportFanin(level - 1, indent + 1);
+   }
+}
+
+void
+CirGate::reportFanout(int level) const
+{
+   assert (level >= 0);
+   _aig->newMark();
+   reportFanout(level, 0);
+}
+
+void
+CirGate::reportFanout(int level, int indent) const
+{
+   GateType type = getType();
+   if (type == CONST_GATE) cout << "CONST 0";
+   else cout << getTypeStr() << ' ' << _id;
+   if (level == 0 || type == PO_GATE) {
+      cout << endl;
+      return;
+   }
+   if (type == AIG_GATE || type == UNDEF_GATE) {
+      if (_aig->isMarked(_id)) { cout << " (*)" << endl; return; }
+      _aig->setMark(_id);
+   }
+   cout << endl;
+   for (const unsigned* p = _aig->fanoutBegin(_id); p != _aig->fanoutEnd(_id); ++p) {
+      cout << string(2 * (indent + 1), ' ');
+      if (*p & 1) cout << '!';
+      CirGate(_aig, *p / 2).reportFanout(level - 1, indent + 1);
+   }
 }
-
-void
-Const::printGate() const {
-    cout << "CONST0" << endl;
-}
-
-void
-Const::reportGate() const{
-    cout << "==================================================" << endl;
-    cout << "= CONST(0), line 0                               =" << endl;
-    cout << "==================================================" << endl;
-}
-
-void
-Const::reportFanin(int level) {
-    assert (level >= 0);
-    cout << "CONST 0" << endl;
-}
-
-void
-Const::reportFanout(int level) {
-    assert (level >= 0);
-    if (GlobalLevel < 0) { GlobalLevel = level; GlobalMark++; }
-    cout << "CONST 0" << endl;
-    if (level != 0) {
-        for (unsigned i = 0; i < _outList.size(); i++) {
-            cout << "  ";
-            if (_invList[i]) cout << '!';
-            _outList[i]->reportFanout(level-1);
-        }
-    }
-    if (GlobalLevel == level) GlobalLevel = -1;
-}
-
-void
-Const::dfs() {}
-
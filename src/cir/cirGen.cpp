@@ -0,0 +1,151 @@
+/****************************************************************************
+  FileName     [ cirGen.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define the synthetic rating dataset generator ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <iostream>
+#include <fstream>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include "cirGen.h"
+#include "util.h"
+
+using namespace std;
+
+// Timestamps span the same period as the MovieLens sample in data/
+#define MAT_GEN_TIME_BEGIN  789652009u
+#define MAT_GEN_TIME_END    1476640644u
+
+/**************************************/
+/*   class MatGenerator functions     */
+/**************************************/
+bool
+MatGenerator::generate(const string& fileName)
+{
+   ofstream outFile(fileName.c_str(), ios::out | ios::binary);
+   if (!outFile) {
+      cerr << "Cannot open file \"" << fileName << "\"!!" << endl;
+      return false;
+   }
+   return generate(outFile);
+}
+
+bool
+MatGenerator::generate(ostream& os)
+{
+   _ratings = 0;
+   if (_users == 0 || _movies == 0 || _latent == 0 || _density <= 0)
+      return false;
+
+   // an engine of its own, so the output depends only on the seed
+   RandomEngine rng(_seed);
+   vector<double> ucdf, mcdf;
+   vector<unsigned> uids, mids;
+   zipfTable(rng, _users, ucdf, uids);
+   zipfTable(rng, _movies, mcdf, mids);
+
+   // Planted factors; each coordinate has variance 1/sqrt(r) so that the
+   // dot product of a user and a movie has unit variance
+   double sd = 1.0 / sqrt(sqrt(double(_latent)));
+   vector<float> userFac(size_t(_users) * _latent);
+   vector<float> movieFac(size_t(_movies) * _latent);
+   for (size_t i = 0; i < userFac.size(); ++i) userFac[i] = sd * gaussian(rng);
+   for (size_t i = 0; i < movieFac.size(); ++i) movieFac[i] = sd * gaussian(rng);
+
+   // Ratings per user; the expectation of the total is the density
+   double total = _density * _users * _movies;
+   vector<unsigned> counts(_users);
+   for (unsigned i = 0; i < _users; ++i) {
+      double expect = total * (ucdf[i] - (i ? ucdf[i-1] : 0.0));
+      unsigned n = unsigned(expect);
+      if (rng.uniform() < expect - n) ++n;
+      if (n == 0) n = 1;
+      if (n > _movies) n = _movies;
+      counts[uids[i]] = n;
+      _ratings += n;
+   }
+
+   if (_binary) {
+      MatBinHeader header;
+      memcpy(header._magic, MAT_BIN_MAGIC, 4);
+      header._version = MAT_BIN_VERSION;
+      header._count = _ratings;
+      os.write((const char*)&header, sizeof(header));
+   }
+   else os << "userId,movieId,rating,timestamp\n";
+
+   vector<unsigned> stamp(_movies, unsigned(-1)), chosen;
+   unsigned timeRange = MAT_GEN_TIME_END - MAT_GEN_TIME_BEGIN;
+   for (unsigned u = 0; u < _users; ++u) {
+      unsigned n = counts[u];
+      chosen.clear();
+      for (unsigned tries = 0; chosen.size() < n && tries < 4 * n; ++tries) {
+         unsigned m = mids[drawZipf(rng, mcdf)];
+         if (stamp[m] == u) continue;
+         stamp[m] = u;
+         chosen.push_back(m);
+      }
+      // heavy users may exhaust the popular head; take the rest in order
+      for (unsigned m = 0; chosen.size() < n && m < _movies; ++m)
+         if (stamp[m] != u) { stamp[m] = u; chosen.push_back(m); }
+      sort(chosen.begin(), chosen.end());
+
+      const float* uf = &userFac[size_t(u) * _latent];
+      for (size_t c = 0; c < chosen.size(); ++c) {
+         const float* mf = &movieFac[size_t(chosen[c]) * _latent];
+         double dot = 0.0;
+         for (unsigned k = 0; k < _latent; ++k) dot += uf[k] * mf[k];
+         double r = floor((3.5 + dot + _noise * gaussian(rng)) * 2 + 0.5) / 2;
+         if (r < 0.5) r = 0.5;
+         if (r > 5.0) r = 5.0;
+         MatBinRecord rec = { u + 1, chosen[c] + 1, float(r),
+                              MAT_GEN_TIME_BEGIN + unsigned(rng(timeRange)) };
+         if (_binary) os.write((const char*)&rec, sizeof(rec));
+         else os << rec._user << ',' << rec._movie << ',' << rec._rating
+                 << ',' << rec._time << '\n';
+      }
+   }
+   os.flush();
+   return os.good();
+}
+
+// Random ranking "ids" of [0, n) and the CDF of rank^(-_alpha) over it
+void
+MatGenerator::zipfTable(const RandomEngine& rng, unsigned n,
+                        vector<double>& cdf, vector<unsigned>& ids) const
+{
+   ids.resize(n);
+   for (unsigned i = 0; i < n; ++i) ids[i] = i;
+   for (unsigned i = n; i > 1; --i) {
+      unsigned j = unsigned(rng.uniform() * i);
+      swap(ids[i-1], ids[j]);
+   }
+   cdf.resize(n);
+   double sum = 0.0;
+   for (unsigned i = 0; i < n; ++i) {
+      sum += pow(double(i + 1), -_alpha);
+      cdf[i] = sum;
+   }
+   for (unsigned i = 0; i < n; ++i) cdf[i] /= sum;
+}
+
+unsigned
+MatGenerator::drawZipf(const RandomEngine& rng, const vector<double>& cdf) const
+{
+   double p = rng.uniform();
+   size_t i = upper_bound(cdf.begin(), cdf.end(), p) - cdf.begin();
+   return i < cdf.size() ? i : cdf.size() - 1;
+}
+
+// Box-Muller
+double
+MatGenerator::gaussian(const RandomEngine& rng) const
+{
+   double u1 = 1.0 - rng.uniform();   // (0, 1]
+   double u2 = rng.uniform();
+   return sqrt(-2.0 * log(u1)) * cos(2.0 * M_PI * u2);
+}
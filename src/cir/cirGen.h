@@ -0,0 +1,70 @@
+/****************************************************************************
+  FileName     [ cirGen.h ]
+  PackageName  [ cir ]
+  Synopsis     [ Define the synthetic rating dataset generator ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef CIR_GEN_H
+#define CIR_GEN_H
+
+#include <string>
+#include <vector>
+#include <iostream>
+#include "rnGen.h"
+
+using namespace std;
+
+// Header of a binary rating snapshot, followed by "_count" MatBinRecord's
+#define MAT_BIN_MAGIC    "MATB"
+#define MAT_BIN_VERSION  1
+
+struct MatBinHeader
+{
+   char               _magic[4];
+   unsigned           _version;
+   unsigned long long _count;
+};
+
+struct MatBinRecord
+{
+   unsigned _user;
+   unsigned _movie;
+   float    _rating;
+   unsigned _time;
+};
+
+// Writes "user,movie,rating,timestamp" ratings drawn from a planted
+// low-rank model. User activity and movie popularity both follow a power
+// law with exponent "_alpha" over a random ranking of the ids. With the
+// same parameters and seed the output is identical on every run.
+class MatGenerator
+{
+public:
+   MatGenerator() : _users(1000), _movies(1000), _density(0.01), _latent(10),
+      _alpha(1.0), _noise(0.5), _seed(0), _binary(false) {}
+
+   bool generate(const string& fileName);
+   bool generate(ostream& os);
+   unsigned long long getRatings() const { return _ratings; }
+
+   unsigned            _users;
+   unsigned            _movies;
+   double              _density;   // ratings / (users x movies)
+   unsigned            _latent;    // rank of the planted model
+   double              _alpha;     // power-law exponent, 0 for uniform
+   double              _noise;     // stddev of the rating noise
+   unsigned            _seed;
+   bool                _binary;    // MATB snapshot instead of CSV
+
+private:
+   unsigned long long  _ratings;
+
+   void zipfTable(const RandomEngine& rng, unsigned n, vector<double>& cdf,
+                  vector<unsigned>& ids) const;
+   unsigned drawZipf(const RandomEngine& rng, const vector<double>& cdf) const;
+   double gaussian(const RandomEngine& rng) const;
+};
+
+#endif // CIR_GEN_H
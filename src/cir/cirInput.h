@@ -0,0 +1,104 @@
+/****************************************************************************
+  FileName     [ cirInput.h ]
+  PackageName  [ cir ]
+  Synopsis     [ Define the buffered reader of rating files and feeds ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef CIR_INPUT_H
+#define CIR_INPUT_H
+
+#include <string>
+#include <cstring>
+#include <cstdlib>
+#include <climits>
+#include <cerrno>
+#include <fcntl.h>
+#include <unistd.h>
+
+using namespace std;
+
+// Bytes the rating reader holds at a time
+#define MAT_READ_BUF  (1 << 20)
+
+// Largest user or movie id; the factor matrices are indexed by the ids
+#define MAT_MAX_ID    ((1 << 24) - 1)
+
+// Unconsumed bytes of a file, a pipe or stdin ("-"), refilled in place
+class MatInput
+{
+public:
+   MatInput(const string& fileName) : _begin(0), _end(0) {
+      _fd = fileName == "-" ? 0 : open(fileName.c_str(), O_RDONLY);
+      _buf = new char[MAT_READ_BUF + 1];
+   }
+   ~MatInput() { if (_fd > 0) close(_fd); delete [] _buf; }
+
+   bool isOpen() const { return _fd >= 0; }
+   char* begin() const { return _buf + _begin; }
+   char* end() const { return _buf + _end; }
+   size_t size() const { return _end - _begin; }
+   bool full() const { return size() == MAT_READ_BUF; }
+   void consume(size_t n) { _begin += n; }
+
+   // Move the unconsumed bytes to the front and read more behind them;
+   // return false at the end of input or if the buffer is full
+   bool fill() {
+      memmove(_buf, _buf + _begin, size());
+      _end -= _begin; _begin = 0;
+      while (_end < MAT_READ_BUF) {
+         ssize_t n = read(_fd, _buf + _end, MAT_READ_BUF - _end);
+         if (n > 0) { _end += n; return true; }
+         if (n == 0 || errno != EINTR) return false;
+      }
+      return false;
+   }
+
+   // Return the next line without its newline, or 0 if no complete line
+   // can be read now (check full() for a line too long to buffer). With
+   // "last", a line at the end of input without a newline is returned too;
+   // a tailed file may still be writing it.
+   char* getLine(bool last) {
+      while (true) {
+         char* line = begin();
+         char* nl = (char*)memchr(line, '\n', size());
+         if (nl == 0) {
+            if (fill()) continue;
+            if (!last || size() == 0 || full()) return 0;
+            nl = end();
+         }
+         *nl = '\0';
+         consume(nl + 1 - line);
+         return line;
+      }
+   }
+
+private:
+   int     _fd;
+   char*   _buf;
+   size_t  _begin;
+   size_t  _end;
+};
+
+// Parse "user,movie,rating[,timestamp]". Return false unless both ids are
+// non-negative integers; a bad rating reads as 0, a missing timestamp as 0.
+inline bool
+matParseRating(char* line, long& user, long& movie, double& rating,
+               unsigned long& stamp)
+{
+   char* end;
+   user = strtol(line, &end, 10);
+   if (end == line || *end != ',' || user < 0 || user > INT_MAX) return false;
+   char* field = end + 1;
+   movie = strtol(field, &end, 10);
+   if (end == field || *end != ',' || movie < 0 || movie > INT_MAX)
+      return false;
+   field = end + 1;
+   rating = strtod(field, &end);
+   if (end == field) rating = 0;
+   stamp = *end == ',' ? strtoul(end + 1, 0, 10) : 0;
+   return true;
+}
+
+#endif // CIR_INPUT_H
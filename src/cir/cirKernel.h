@@ -0,0 +1,61 @@
+/****************************************************************************
+  FileName     [ cirKernel.h ]
+  PackageName  [ cir ]
+  Synopsis     [ Define the dense vector kernels of matrix factorization ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef CIR_KERNEL_H
+#define CIR_KERNEL_H
+
+// Kept inline and branch-free so that -O3 can vectorize the loops
+
+// return x . y
+inline double
+matDot(const double* x, const double* y, int n)
+{
+   double sum = 0.0;
+   for (int k = 0; k < n; ++k)
+      sum += x[k] * y[k];
+   return sum;
+}
+
+// y += a * x
+inline void
+matAxpy(double a, const double* x, double* y, int n)
+{
+   for (int k = 0; k < n; ++k)
+      y[k] += a * x[k];
+}
+
+// y += a * x in single precision
+inline void
+matAxpyFloat(float a, const float* x, float* y, int n)
+{
+   for (int k = 0; k < n; ++k)
+      y[k] += a * x[k];
+}
+
+// return x . y of int8 vectors, widened to int
+inline int
+matDotInt8(const signed char* x, const signed char* y, int n)
+{
+   int sum = 0;
+   for (int k = 0; k < n; ++k)
+      sum += x[k] * y[k];
+   return sum;
+}
+
+// One SGD step on rating error "err" for user row "u" and movie row "m".
+// "m" is updated with the already-updated u[k], as in the original loop.
+inline void
+matSgdStep(double* u, double* m, double err, double lr, double lambda, int n)
+{
+   for (int k = 0; k < n; ++k) {
+      u[k] += lr * (err * m[k] - lambda * u[k]);
+      m[k] += lr * (err * u[k] - lambda * m[k]);
+   }
+}
+
+#endif // CIR_KERNEL_H
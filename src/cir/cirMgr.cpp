@@ -13,8 +13,16 @@
 #include <cassert>
 #include <cstring>
 #include <cstdlib>
+#include <algorithm>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include "cirMgr.h"
 #include "cirGate.h"
+#include "cirGen.h"
+#include "cirCkpt.h"
+#include "cirInput.h"
 #include "util.h"
 
 using namespace std;
@@ -25,7 +33,6 @@ using namespace std;
 /*   Global variable and enum  */
 /*******************************/
 CirMgr* cirMgr = 0;
-unsigned GlobalMark = 0;
 
 enum CirParseError {
    EXTRA_SPACE,
@@ -58,7 +65,7 @@ static unsigned colNo  = 0;  // in printing, colNo needs to ++
 static char buf[1024];
 static string errMsg;
 static int errInt;
-static CirGate *errGate;
+static CirGate errGate;
 
 static bool
 parseError(CirParseError err)
@@ -123,7 +130,7 @@ parseError(CirParseError err)
       case REDEF_GATE:
          cerr << "[ERROR] Line " << lineNo+1 << ": Literal \"" << errInt
               << "\" is redefined, previously defined as "
-              << errGate->getTypeStr() << " in line " << errGate->getLineNo()
+              << errGate.getTypeStr() << " in line " << errGate.getLineNo()+1
               << "!!" << endl;
          break;
       case REDEF_SYMBOLIC_NAME:
@@ -147,94 +154,564 @@ parseError(CirParseError err)
    return false;
 }
 
+// Cursor of readCircuit() over the mapped file. The current line is
+// [lineBegin, lineEnd), where lineEnd is at its '\n' or at fileEnd.
+static const char *fileEnd = 0;
+static const char *lineBegin = 0;
+static const char *lineEnd = 0;
+static const char *cur = 0;
+
+// Enter the line at "p"; return false if it does not end with '\n'
+static bool
+beginLine(const char* p)
+{
+   lineBegin = cur = p;
+   lineEnd = (const char*)memchr(p, '\n', fileEnd - p);
+   if (lineEnd != 0) return true;
+   lineEnd = fileEnd;
+   return false;
+}
+
+static inline const char*
+nextLine()
+{
+   return lineEnd < fileEnd ? lineEnd + 1 : fileEnd;
+}
+
+// The end of a line reads as '\n'
+static inline char
+peekChar()
+{
+   return cur < lineEnd ? *cur : '\n';
+}
+
+static inline bool
+isSpace(char c)
+{
+   return isspace((unsigned char)c);
+}
+
+static bool
+parseError(CirParseError err, const char* at)
+{
+   colNo = at - lineBegin;
+   return parseError(err);
+}
+
+// Copy the token at "p" into buf for an error message
+static const char*
+copyToken(const char* p)
+{
+   size_t n = 0;
+   while (p + n < lineEnd && !isSpace(p[n]) && n < sizeof(buf) - 1) ++n;
+   memcpy(buf, p, n);
+   buf[n] = 0;
+   return buf;
+}
+
+// The unsigned number of field "name" at cur
+static bool
+parseNum(unsigned& num, const char* name)
+{
+   char c = peekChar();
+   if (c == ' ') return parseError(EXTRA_SPACE, cur);
+   if (c == '\n') { errMsg = name; return parseError(MISSING_NUM, cur); }
+   if (isSpace(c)) { errInt = c; return parseError(ILLEGAL_WSPACE, cur); }
+   const char* p = cur;
+   for (num = 0; p < lineEnd && isdigit((unsigned char)*p); ++p)
+      num = num * 10 + (*p - '0');
+   if (p < lineEnd && !isSpace(*p)) {
+      errMsg = string(name) + "(" + copyToken(cur) + ")";
+      return parseError(ILLEGAL_NUM);
+   }
+   cur = p;
+   return true;
+}
+
+// The single space before field "name"; a missing header field is
+// reported as such
+static bool
+parseSpace(const char* name = 0)
+{
+   char c = peekChar();
+   if (c == ' ') { ++cur; return true; }
+   if (c == '\n' && name != 0) {
+      errMsg = name;
+      return parseError(MISSING_NUM, cur);
+   }
+   return parseError(MISSING_SPACE, cur);
+}
+
+static bool
+parseNewline()
+{
+   return cur == lineEnd ? true : parseError(MISSING_NEWLINE, cur);
+}
+
+// A delta of the binary AND section, 7 bits per byte, low bits first;
+// false at the end of the file or past 5 bytes
+static bool
+readDelta(const char*& p, unsigned& x)
+{
+   x = 0;
+   for (unsigned shift = 0; shift < 35; shift += 7) {
+      if (p == fileEnd) return false;
+      unsigned char c = *p++;
+      x |= unsigned(c & 0x7f) << shift;
+      if (!(c & 0x80)) return true;
+   }
+   return false;
+}
+
+// Append "x" to "out" 7 bits per byte, low bits first (see readDelta())
+static void
+putDelta(string& out, unsigned x)
+{
+   while (x & ~0x7fu) {
+      out += char((x & 0x7f) | 0x80);
+      x >>= 7;
+   }
+   out += char(x);
+}
+
 /**************************************************************/
 /*   class CirMgr member functions for circuit construction   */
 /**************************************************************/
 CirMgr::~CirMgr(void)
 {
-    for (unsigned i = 0; i<_totalList.size(); i++) {
-        if (_totalList[i] != 0) {
-            delete _totalList[i];
-        }
-    }
-    _totalList.clear();
-    _piList.resize(0);
-    _poList.resize(0);
-    _netList.resize(0);
-    _floatList.resize(0);
-    _unusedList.resize(0);
+    stopTraining();
+    delete _resume;
+    clearCircuit();
+    clearFactors();
+}
+
+void
+CirMgr::clearCircuit()
+{
+    _aig.clear();
+    _netList.clear();
+    _levelList.clear();
+    resetSim();
+    _floatList.clear();
+    _unusedList.clear();
+    _max = _pis = _pos = _aigs = _maxLevel = 0;
 }
 
+// Ratings are read once, in MAT_READ_BUF chunks, so that "fileName" can
+// be a pipe, a FIFO or "-" for stdin
 bool
 CirMgr::readMatrix(const string& fileName)
 {
-    fstream matFile;
-    matFile.open(fileName.c_str());
-    if (matFile.fail()) {
+    MyUsagePhase phase(myUsage, "parse");
+    MatInput in(fileName);
+    if (!in.isOpen()) {
         cout << "Cannot open file \"" << fileName << "\"!!" << endl;
         return false;
     }
+    while (in.size() < 4 && in.fill()) ;
+    if (in.size() >= 4 && memcmp(in.begin(), MAT_BIN_MAGIC, 4) == 0)
+        return readBinary(in, fileName);
+    return readCsv(in, fileName);
+}
 
-    int users = 0, movies = 0, ratings = 0;
-    while (matFile.good()) {
-        string line;
-        int userId, movieId;
-        getline(matFile, line, ',');
-        myStr2Int(line, userId);
-        getline(matFile, line, ',');
-        myStr2Int(line, movieId);
-        getline(matFile, line);
+// Only the rated entries in [_since, _until) are kept; the header and blank
+// lines are skipped. The id maxima also cover the unrated entries, as the
+// matrices are indexed by the ids. A missing timestamp reads as 0.
+bool
+CirMgr::readCsv(MatInput& in, const string& fileName)
+{
+    int users = 0, movies = 0;
+    unsigned long lineNo = 0;
+    char* line;
+    while ((line = in.getLine(true)) != 0) {
+        long userId, movieId;
+        double rating;
+        unsigned long stamp;
+        ++lineNo;
+        if (!matParseRating(line, userId, movieId, rating, stamp)) continue;
+        if (userId > MAT_MAX_ID || movieId > MAT_MAX_ID) {
+            cout << "Id is larger than " << MAT_MAX_ID << " on line " << lineNo
+                 << " of \"" << fileName << "\"!!" << endl;
+            _ratingList.clear(); _timeList.clear();
+            return false;
+        }
+        if (stamp < _since || stamp >= _until) continue;
         users = userId > users ? userId : users;
         movies = movieId > movies ? movieId : movies;
+        if (rating <= 0) continue;
+        Rating r = { unsigned(userId), unsigned(movieId), float(rating) };
+        _ratingList.push_back(r);
+        _timeList.push_back(stamp);
     }
-    double** mat = new double*[users+1];
-    for(int i = 0; i < users+1; ++i) {
-        mat[i] = new double[movies+1];
-        for (int j = 0; j < movies+1; ++j)
-            mat[i][j] = 0.0;
+    if (in.full()) {
+        cout << "Line is too long in \"" << fileName << "\"!!" << endl;
+        _ratingList.clear(); _timeList.clear();
+        return false;
     }
-    matFile.close();
 
-    matFile.open(fileName.c_str());
-    while (matFile.good()) {
-        string line;
-        int userId, movieId;
-        double rating;
-        getline(matFile, line, ',');
-        myStr2Int(line, userId);
-        getline(matFile, line, ',');
-        myStr2Int(line, movieId);
-        getline(matFile, line, ',');
-        rating = atof(line.c_str());
-        ++ratings;
-        getline(matFile, line);
-        mat[userId][movieId] = rating;
-    }
-    matFile.close();
-
-    vector<double> count;
-    count.resize(movies+1);
-    int userCount = 0, movieCount = 0;
-    for (int i = 0; i < users+1; ++i) {
-        bool exist = false;
-        for (int j = 0; j < movies+1; ++j) {
-            if (mat[i][j] != 0) {
-                count[j] += mat[i][j];
-                exist = true;
+    _maxUserId = users;
+    _maxMovieId = movies;
+    countRatings();
+    return true;
+}
+
+// A MATB snapshot (see cirGen.h)
+bool
+CirMgr::readBinary(MatInput& in, const string& fileName)
+{
+    while (in.size() < sizeof(MatBinHeader) && in.fill()) ;
+    MatBinHeader header;
+    if (in.size() < sizeof(header)) {
+        cout << "Illegal binary rating file \"" << fileName << "\"!!" << endl;
+        return false;
+    }
+    memcpy(&header, in.begin(), sizeof(header));
+    in.consume(sizeof(header));
+    if (header._version != MAT_BIN_VERSION) {
+        cout << "Illegal binary rating file \"" << fileName << "\"!!" << endl;
+        return false;
+    }
+
+    unsigned users = 0, movies = 0;
+    if (_since == 0 && _until == UINT_MAX) {
+        _ratingList.reserve(header._count);
+        _timeList.reserve(header._count);
+    }
+    for (unsigned long long left = header._count; left > 0; ) {
+        size_t n = in.size() / sizeof(MatBinRecord);
+        if (n == 0) {
+            if (in.fill()) continue;
+            cout << "Binary rating file \"" << fileName << "\" is truncated!!"
+                 << endl;
+            _ratingList.clear(); _timeList.clear();
+            return false;
+        }
+        if (n > left) n = left;
+        for (size_t i = 0; i < n; ++i) {
+            MatBinRecord rec;
+            memcpy(&rec, in.begin() + i * sizeof(rec), sizeof(rec));
+            if (rec._user > MAT_MAX_ID || rec._movie > MAT_MAX_ID) {
+                cout << "Id is larger than " << MAT_MAX_ID << " in record "
+                     << header._count - left + i + 1 << " of \"" << fileName
+                     << "\"!!" << endl;
+                _ratingList.clear(); _timeList.clear();
+                return false;
             }
+            if (rec._rating <= 0 || rec._time < _since || rec._time >= _until)
+                continue;
+            Rating r = { rec._user, rec._movie, rec._rating };
+            _ratingList.push_back(r);
+            _timeList.push_back(rec._time);
+            users = r._user > users ? r._user : users;
+            movies = r._movie > movies ? r._movie : movies;
         }
-        if (exist) userCount++;
-    }
-    for (int j = 0; j < movies+1; ++j) {
-        if (count[j] > 0) movieCount++;
+        in.consume(n * sizeof(MatBinRecord));
+        left -= n;
     }
 
-    _ratingMatrix = mat;
     _maxUserId = users;
     _maxMovieId = movies;
-    _ratings = ratings;
+    countRatings();
+    return true;
+}
+
+// Statistics and the per-user index of the ratings in _ratingList
+void
+CirMgr::countRatings()
+{
+    MyUsagePhase phase(myUsage, "build");
+    vector<bool> userExist(_maxUserId+1, false), movieExist(_maxMovieId+1, false);
+    for (size_t r = 0, n = _ratingList.size(); r < n; ++r)
+        userExist[_ratingList[r]._user] = movieExist[_ratingList[r]._movie] = true;
+
+    int userCount = 0, movieCount = 0;
+    for (int i = 0; i < _maxUserId+1; ++i)
+        if (userExist[i]) userCount++;
+    for (int j = 0; j < _maxMovieId+1; ++j)
+        if (movieExist[j]) movieCount++;
+
+    buildRatingIndex();
+    lock_guard<mutex> lock(_statusMutex);   // MATPrint reads them during a stream
+    _ratings = _ratingList.size();
     _users = userCount;
     _movies = movieCount;
+}
+
+// The file is mapped and parsed in one pass, with the error reporting of
+// parseError(), straight into _aig, which is sized by the header. A fanin
+// used before its definition is UNDEF until its AIG line is read.
+bool
+CirMgr::readCircuit(const string& fileName)
+{
+    MyUsagePhase phase(myUsage, "parse");
+    int fd = open(fileName.c_str(), O_RDONLY);
+    struct stat st;
+    if (fd < 0 || fstat(fd, &st) != 0) {
+        if (fd >= 0) close(fd);
+        cerr << "Cannot open design \"" << fileName << "\"!!" << endl;
+        return false;
+    }
+    size_t size = st.st_size;
+    void* map = 0;
+    if (size > 0) {
+        map = mmap(0, size, PROT_READ, MAP_PRIVATE, fd, 0);
+        if (map == MAP_FAILED) {
+            close(fd);
+            cerr << "Cannot open design \"" << fileName << "\"!!" << endl;
+            return false;
+        }
+        madvise(map, size, MADV_SEQUENTIAL);
+    }
+    close(fd);
+
+    clearCircuit();
+    const char* data = map ? (const char*)map : "";
+    fileEnd = data + size;
+    bool ok = parseCircuit(data);
+    if (map) munmap(map, size);
+    if (ok) _aig.buildFanouts();
+    if (!ok) {
+        clearCircuit();
+        return false;
+    }
+    traversal();
+    return true;
+}
+
+bool
+CirMgr::parseCircuit(const char* data)
+{
+    lineNo = 0;
+    beginLine(data);   // the header may end the file without a '\n'
+    bool binary;
+    if (!parseHeader(binary)) return false;
+
+    for (unsigned i = 0; i < _pis; ++i) {
+        if (binary) {
+            _aig.setPi(i + 1, 0);
+            continue;
+        }
+        ++lineNo;
+        if (!beginLine(nextLine())) {
+            errMsg = "PI";
+            return parseError(MISSING_DEF);
+        }
+        if (!parsePi()) return false;
+    }
+    for (unsigned i = 0; i < _pos; ++i) {
+        ++lineNo;
+        if (!beginLine(nextLine())) {
+            errMsg = "PO";
+            return parseError(MISSING_DEF);
+        }
+        if (!parsePo(i)) return false;
+    }
+    if (binary) {
+        const char* p = nextLine();
+        return parseDeltas(p) && parseSymbols(p);
+    }
+    for (unsigned i = 0; i < _aigs; ++i) {
+        ++lineNo;
+        if (!beginLine(nextLine())) {
+            errMsg = "AIG";
+            return parseError(MISSING_DEF);
+        }
+        if (!parseAig()) return false;
+    }
+    return parseSymbols(nextLine());
+}
+
+// aag|aig M I L O A, without latches
+bool
+CirMgr::parseHeader(bool& binary)
+{
+    static const char* names[5] = {
+        "number of variables", "number of PIs", "number of latches",
+        "number of POs", "number of AIGs"
+    };
+    char c = peekChar();
+    if (c == ' ') return parseError(EXTRA_SPACE, cur);
+    if (c != '\n' && isSpace(c)) {
+        errInt = c;
+        return parseError(ILLEGAL_WSPACE, cur);
+    }
+    const char* p = cur;
+    while (p < lineEnd && !isSpace(*p)) ++p;
+    if (p == cur) {
+        errMsg = "aag";
+        return parseError(MISSING_IDENTIFIER);
+    }
+    binary = p - cur >= 3 && memcmp(cur, "aig", 3) == 0;
+    if (p - cur != 3 || (!binary && memcmp(cur, "aag", 3) != 0)) {
+        if (p - cur > 3 && isdigit(cur[3]) &&
+            (binary || memcmp(cur, "aag", 3) == 0))
+            return parseError(MISSING_SPACE, cur + 3);
+        errMsg = copyToken(cur);
+        return parseError(ILLEGAL_IDENTIFIER);
+    }
+    cur = p;
+
+    unsigned num[5];
+    for (int i = 0; i < 5; ++i)
+        if (!parseSpace(names[i]) || !parseNum(num[i], names[i])) return false;
+    if (!parseNewline()) return false;
+    if ((unsigned long long)num[0] < (unsigned long long)num[1] + num[2] + num[4]) {
+        errMsg = "Number of variables";
+        errInt = num[0];
+        return parseError(NUM_TOO_SMALL);
+    }
+    if (num[2] != 0) {
+        errMsg = "latches";
+        return parseError(ILLEGAL_NUM);
+    }
+
+    _max = num[0]; _pis = num[1]; _pos = num[3]; _aigs = num[4];
+    _aig.reset(_max + _pos + 1);
+    return true;
+}
+
+// "lit" at "at" defines a gate of "type"
+bool
+CirMgr::checkDef(unsigned lit, const char* type, const char* at)
+{
+    errInt = lit;
+    if (lit / 2 == 0) return parseError(REDEF_CONST, at);
+    if (lit / 2 > _max) return parseError(MAX_LIT_ID, at);
+    if (lit & 1) {
+        errMsg = type;
+        return parseError(CANNOT_INVERTED, at);
+    }
+    if (_aig.getType(lit / 2) != UNDEF_GATE) {
+        errGate = CirGate(&_aig, lit / 2);
+        return parseError(REDEF_GATE);
+    }
+    return true;
+}
+
+bool
+CirMgr::parsePi()
+{
+    unsigned lit;
+    const char* at = cur;
+    if (!parseNum(lit, "PI literal ID") || !checkDef(lit, "PI", at) ||
+        !parseNewline()) return false;
+    _aig.setPi(lit / 2, lineNo);
+    return true;
+}
+
+bool
+CirMgr::parsePo(unsigned i)
+{
+    unsigned lit;
+    const char* at = cur;
+    if (!parseNum(lit, "PO literal ID")) return false;
+    if (lit / 2 > _max) {
+        errInt = lit;
+        return parseError(MAX_LIT_ID, at);
+    }
+    if (!parseNewline()) return false;
+    _aig.setPo(_max + 1 + i, lineNo, lit);
+    return true;
+}
+
+bool
+CirMgr::parseAig()
+{
+    unsigned lit, in[2];
+    const char* at = cur;
+    if (!parseNum(lit, "AIG gate literal ID") ||
+        !checkDef(lit, "AIG gate", at)) return false;
+    for (int i = 0; i < 2; ++i) {
+        if (!parseSpace()) return false;
+        at = cur;
+        if (!parseNum(in[i], "AIG input literal ID")) return false;
+        if (in[i] / 2 > _max) {
+            errInt = in[i];
+            return parseError(MAX_LIT_ID, at);
+        }
+    }
+    if (!parseNewline()) return false;
+    _aig.setAig(lit / 2, lineNo, in[0], in[1]);
+    return true;
+}
+
+// The AND gates of a binary file: gate i is 2*(I+1+i) and its fanins are
+// encoded as the deltas lhs-rhs0 and rhs0-rhs1, 7 bits per byte. They take
+// the place of one line of the file.
+bool
+CirMgr::parseDeltas(const char*& p)
+{
+    ++lineNo;
+    for (unsigned i = 0; i < _aigs; ++i) {
+        unsigned lhs = 2 * (_pis + 1 + i), delta[2];
+        if (!readDelta(p, delta[0]) || !readDelta(p, delta[1])) {
+            if (p == fileEnd) {
+                errMsg = "AIG";
+                return parseError(MISSING_DEF);
+            }
+            delta[0] = 0;   // longer than 5 bytes
+        }
+        if (delta[0] == 0 || delta[0] > lhs || delta[1] > lhs - delta[0]) {
+            sprintf(buf, "fanins of AIG %u", lhs / 2);
+            errMsg = buf;
+            return parseError(ILLEGAL_NUM);
+        }
+        _aig.setAig(lhs / 2, lineNo, lhs - delta[0], lhs - delta[0] - delta[1]);
+    }
+    return true;
+}
+
+// Symbols "i<index> <name>" and "o<index> <name>" in any order, up to a
+// comment section "c". A last line without '\n' is ignored.
+bool
+CirMgr::parseSymbols(const char* p)
+{
+    for (; p < fileEnd; p = nextLine()) {
+        ++lineNo;
+        if (!beginLine(p)) break;
+        char type = peekChar();
+        if (type == '\n' && nextLine() == fileEnd) break;   // a final blank line
+        if (type == ' ') return parseError(EXTRA_SPACE, cur);
+        if (type != '\n' && isSpace(type)) {
+            errInt = type;
+            return parseError(ILLEGAL_WSPACE, cur);
+        }
+        if (type == 'c') {
+            ++cur;
+            return parseNewline();
+        }
+        if (type != 'i' && type != 'o') {
+            errMsg = type == '\n' ? string() : string(1, type);
+            return parseError(ILLEGAL_SYMBOL_TYPE, cur);
+        }
+        ++cur;
+
+        unsigned idx;
+        if (!parseNum(idx, "symbol index")) return false;
+        if (idx >= (type == 'i' ? _pis : _pos)) {
+            errMsg = type == 'i' ? "PI index" : "PO index";
+            errInt = idx;
+            return parseError(NUM_TOO_BIG);
+        }
+        if (cur < lineEnd && *cur != ' ') return parseError(MISSING_SPACE, cur);
+        if (cur < lineEnd) ++cur;
+        if (cur == lineEnd) {
+            errMsg = "symbolic name";
+            return parseError(MISSING_IDENTIFIER);
+        }
+        for (const char* q = cur; q < lineEnd; ++q)
+            if ((unsigned char)*q < 32 || *q == 127) {
+                errInt = *q;
+                return parseError(ILLEGAL_SYMBOL_NAME, q);
+            }
+        unsigned id = type == 'i' ? _aig.getPiList()[idx] : _aig.getPoList()[idx];
+        if (!_aig.getSymbol(id).empty()) {
+            errMsg = string(1, type);
+            errInt = idx;
+            return parseError(REDEF_SYMBOLIC_NAME);
+        }
+        _aig.setSymbol(id, string(cur, lineEnd));
+    }
     return true;
 }
 
@@ -253,97 +730,57 @@ Circuit Statistics
 void
 CirMgr::printSummary() const
 {
+    int users, movies, ratings, maxUserId, maxMovieId;
+    {
+        // a background stream may be growing the matrix
+        lock_guard<mutex> lock(_statusMutex);
+        users = _users; movies = _movies; ratings = _ratings;
+        maxUserId = _maxUserId; maxMovieId = _maxMovieId;
+    }
     cout << endl;
+    if (hasCircuit()) {
+        cout << "Circuit Statistics" << endl
+             << "==================" << endl
+             << "  PI  " << setw(10) << right << _pis << endl
+             << "  PO  " << setw(10) << right << _pos << endl
+             << "  AIG " << setw(10) << right << _aigs << endl
+             << "------------------" << endl
+             << "  Total" << setw(9) << right << _pis + _pos + _aigs << endl
+             << "  Level" << setw(9) << right << _maxLevel << endl;
+        if (ratings == 0) return;
+        cout << endl;
+    }
     cout << "Matrix Statistics" << endl
          << "==================" << endl
-         << "      USERS " << setw(11) << right << _users << endl
-         << "     MOVIES " << setw(11) << right << _movies << endl
-         << "    RATINGS " << setw(11) << right << _ratings << endl
+         << "      USERS " << setw(11) << right << users << endl
+         << "     MOVIES " << setw(11) << right << movies << endl
+         << "    RATINGS " << setw(11) << right << ratings << endl
          << "------------------" << endl
-         << " MAX_USERID " << setw(11) << right << _maxUserId << endl
-         << "MAX_MOVIEID " << setw(11) << right << _maxMovieId << endl;
+         << " MAX_USERID " << setw(11) << right << maxUserId << endl
+         << "MAX_MOVIEID " << setw(11) << right << maxMovieId << endl;
 }
 
-void
-CirMgr::printSettings() const
+CirGate
+CirMgr::getGate(unsigned gid) const
 {
-    
-}
-
-void
-CirMgr::train()
-{
-    _latent = 200;
-    _iterations = 1000;
-    _learningRate = 0.01;
-    _lambda = 0.0;
-    double** userMatrix = new double*[_maxUserId+1];
-    for (int i = 0; i < _maxUserId+1; ++i) {
-        userMatrix[i] = new double[_latent];
-        for (int j = 0; j < _latent; ++j) {
-            userMatrix[i][j] = (rand() % 2000 - 1000) * 0.0001;
-        }
-    }
-    double** movieMatrix = new double*[_latent];
-    for (int i = 0; i < _latent; ++i) {
-        movieMatrix[i] = new double[_maxMovieId+1];
-        for (int j = 0; j < _maxMovieId+1; ++j) {
-            movieMatrix[i][j] = (rand() % 2000 - 1000) * 0.0001;
-        }
-    }
-
-    for (int iters = 1; iters < _iterations; ++iters) {
-        for (int i = 0; i < _maxUserId+1; ++i) {
-            for (int j = 0; j < _maxMovieId+1; ++j) {
-                double sum = 0.0;
-                for (int k = 0; k < _latent; ++k) 
-                    sum += userMatrix[i][k] * movieMatrix[k][j];
-                if (_ratingMatrix[i][j] > 0) {
-                    double eij = _ratingMatrix[i][j] - sum;
-                    for (int k = 0; k < _latent; ++k) {
-                        userMatrix[i][k] += _learningRate * (eij * movieMatrix[k][j] - _lambda * userMatrix[i][k]);
-                        movieMatrix[k][j] += _learningRate * (eij * userMatrix[i][k] - _lambda * movieMatrix[k][j]);
-                    }
-                }
-            }
-        }
-        double e = 0;
-        for (int i = 0; i < _maxUserId+1; ++i) {
-            for (int j = 0; j < _maxMovieId+1; ++j) {
-                double sum = 0.0;
-                for (int k = 0; k < _latent; ++k)
-                    sum += userMatrix[i][k] * movieMatrix[k][j];
-                if (_ratingMatrix[i][j] > 0) {
-                    e += (_ratingMatrix[i][j] - sum) * (_ratingMatrix[i][j] - sum);
-                    for (int k = 0; k < _latent; ++k) 
-                        e += _lambda * ( userMatrix[i][k] * userMatrix[i][k] + 
-                                        movieMatrix[k][j] * movieMatrix[k][j] );
-                }
-            }
-        }
-        cout << "iterations: " << iters << ", traning error: " << e << endl; 
-    }
-
-
-    _userMatrix = userMatrix;
-    _movieMatrix = movieMatrix;
+    return CirGate(&_aig, gid);
 }
 
 void
 CirMgr::printPIs() const
 {
-    unsigned size = _piList.size();
+    const IdList& piList = _aig.getPiList();
     cout << "PIs of the circuit:";
-    for (unsigned i = 0; i < size; i++) cout << ' ' << _piList[i]->getID();
+    for (unsigned i = 0; i < piList.size(); i++) cout << ' ' << piList[i];
     cout << endl;
 }
 
 void
 CirMgr::printPOs() const
 {
-    unsigned size = _poList.size();
+    const IdList& poList = _aig.getPoList();
     cout << "POs of the circuit:";
-    for (unsigned i = 0; i < size; i++) cout << ' ' << _poList[i]->getID();
+    for (unsigned i = 0; i < poList.size(); i++) cout << ' ' << poList[i];
     cout << endl;
 }
 
@@ -366,42 +803,157 @@ CirMgr::printFloatGates() const
 void
 CirMgr::writeAag(ostream& outfile) const
 {
-    unsigned aigs = 0;
-    vector<CirGate*> aigList;
-    for (unsigned i = 0; i < _netList.size();i++){
-        if(_netList[i]->getTypeStr() == "AIG") {
-            ++aigs; aigList.push_back(_netList[i]);
+    const IdList& piList = _aig.getPiList();
+    const IdList& poList = _aig.getPoList();
+    IdList aigList;
+    for (unsigned i = 0; i < _netList.size(); i++)
+        if (_aig.getType(_netList[i]) == AIG_GATE) aigList.push_back(_netList[i]);
+    outfile << "aag " << _max << ' ' << _pis << " 0 " << _pos << ' ' << aigList.size() << '\n';
+    for (unsigned i = 0; i < piList.size(); i++) outfile << 2 * piList[i] << '\n';
+    for (unsigned i = 0; i < poList.size(); i++) outfile << _aig.getFanin(poList[i], 0) << '\n';
+    for (unsigned i = 0; i < aigList.size(); i++)
+        outfile << 2 * aigList[i] << ' ' << _aig.getFanin(aigList[i], 0) << ' '
+                << _aig.getFanin(aigList[i], 1) << '\n';
+    writeSymbols(outfile);
+    outfile.flush();
+}
+
+// In binary AIGER the PIs are 1..I and the AIGs I+1..I+A, each above its
+// fanins, so the AIGs of the netlist are renumbered in DFS order. Fanins
+// that are not defined cannot be written.
+bool
+CirMgr::writeAig(ostream& outfile) const
+{
+    const IdList& piList = _aig.getPiList();
+    const IdList& poList = _aig.getPoList();
+    IdList newId(_aig.size(), 0), aigList;
+    for (unsigned i = 0; i < piList.size(); i++) newId[piList[i]] = i + 1;
+    for (unsigned i = 0; i < _netList.size(); i++)
+        if (_aig.getType(_netList[i]) == AIG_GATE) {
+            aigList.push_back(_netList[i]);
+            newId[_netList[i]] = _pis + aigList.size();
         }
+
+    string ands;   // the AND section, written at once
+    ands.reserve(aigList.size() * 4);
+    for (unsigned i = 0; i < aigList.size(); i++) {
+        unsigned lhs = 2 * (_pis + 1 + i);
+        unsigned lit[2] = { _aig.getFanin(aigList[i], 0), _aig.getFanin(aigList[i], 1) };
+        for (int j = 0; j < 2; j++) {
+            if (_aig.getType(lit[j] / 2) == UNDEF_GATE) {
+                cerr << "Error: AIG(" << aigList[i]
+                     << ") has an undefined fanin!!" << endl;
+                return false;
+            }
+            lit[j] = 2 * newId[lit[j] / 2] + (lit[j] & 1);
+        }
+        if (lit[0] < lit[1]) swap(lit[0], lit[1]);
+        if (lit[0] >= lhs) {
+            cerr << "Error: AIG(" << aigList[i] << ") is on a cycle!!" << endl;
+            return false;
+        }
+        putDelta(ands, lhs - lit[0]);
+        putDelta(ands, lit[0] - lit[1]);
     }
-    outfile << "aag " << _max << ' ' << _pis << " 0 " << _pos << ' ' << aigs << endl;
-    for (unsigned i = 0; i < _piList.size(); i++) outfile << 2*(_piList[i]->getID()) << endl;
-    for (unsigned i = 0; i < _poList.size(); i++) outfile << _poList[i]->linkValue() << endl;
-    for (unsigned i = 0; i < aigs; i++) {
-            outfile << 2*(aigList[i]->getID()) << ' ' 
-                    << aigList[i]->linkValue() << ' ' << aigList[i]->linkValue(false) << endl;
+    for (unsigned i = 0; i < poList.size(); i++)
+        if (_aig.getType(_aig.getFanin(poList[i], 0) / 2) == UNDEF_GATE) {
+            cerr << "Error: PO(" << poList[i]
+                 << ") has an undefined fanin!!" << endl;
+            return false;
+        }
+
+    outfile << "aig " << _pis + aigList.size() << ' ' << _pis << " 0 "
+            << _pos << ' ' << aigList.size() << '\n';
+    for (unsigned i = 0; i < poList.size(); i++) {
+        unsigned lit = _aig.getFanin(poList[i], 0);
+        outfile << 2 * newId[lit / 2] + (lit & 1) << '\n';
     }
-    for (unsigned i = 0; i < _piList.size(); i++){
-        string sym = _piList[i]->getSymbol();
-        if (!sym.empty()) outfile << 'i' << i << ' ' << sym << endl;
+    outfile.write(ands.data(), ands.size());
+    writeSymbols(outfile);
+    outfile.flush();
+    return true;
+}
+
+void
+CirMgr::writeSymbols(ostream& outfile) const
+{
+    const IdList& piList = _aig.getPiList();
+    const IdList& poList = _aig.getPoList();
+    for (unsigned i = 0; i < piList.size(); i++) {
+        const string& sym = _aig.getSymbol(piList[i]);
+        if (!sym.empty()) outfile << 'i' << i << ' ' << sym << '\n';
     }
-    for (unsigned i = 0; i < _poList.size(); i++){
-        string sym = _poList[i]->getSymbol();
-        if (!sym.empty()) outfile << 'o' << i << ' ' << sym << endl;
+    for (unsigned i = 0; i < poList.size(); i++) {
+        const string& sym = _aig.getSymbol(poList[i]);
+        if (!sym.empty()) outfile << 'o' << i << ' ' << sym << '\n';
     }
 }
 
+// _netList: the gates reachable from the POs, fanins first, PO by PO.
+// The AIGs that no PO reaches are then visited for their levels only.
 void
 CirMgr::traversal()
 {
-    GlobalMark++;
-    for (unsigned i = 0; i < _pos; i++) {
-        _poList[i]->dfs();
-        setNet(_poList[i]);
+    const IdList& poList = _aig.getPoList();
+    const IdList& aigList = _aig.getAigList();
+    _netList.clear();
+    _floatList.clear();
+    _unusedList.clear();
+    _netList.reserve(_aig.size());
+    _levelList.assign(_aig.size(), 0);
+    _maxLevel = 0;
+    _aig.newMark();
+    for (unsigned i = 0; i < poList.size(); i++) {
+        unsigned in = _aig.getFanin(poList[i], 0) / 2;
+        if (!_aig.isMarked(in)) dfs(in, _netList);
+        _netList.push_back(poList[i]);
+        _levelList[poList[i]] = _levelList[in];
+        if (_levelList[in] > _maxLevel) _maxLevel = _levelList[in];
+    }
+    IdList unreached;
+    for (unsigned i = 0; i < aigList.size(); i++)
+        if (!_aig.isMarked(aigList[i])) dfs(aigList[i], unreached);
+
+    for (unsigned i = 1; i < _aig.size(); i++) {
+        CirGate gate(&_aig, i);
+        if (gate.checkUndef()) continue;
+        if (gate.checkFloat())  _floatList.push_back(i);
+        if (gate.checkUnused()) _unusedList.push_back(i);
     }
-    unsigned size = _totalList.size();
-    for (unsigned i = 1; i < size; i++) {
-        if(_totalList[i] == 0 || _totalList[i]->checkUndef()) continue;
-        if(_totalList[i]->checkFloat())   _floatList.push_back(_totalList[i]->getID());
-        if(_totalList[i]->checkUnused()) _unusedList.push_back(_totalList[i]->getID());
+}
+
+// Append the unmarked gates of the fanin cone of "root" to "order", fanins
+// first, and levelize them. The recursion on the fanins is unrolled on an
+// explicit stack, whose entries are an AIG and the number of its fanins
+// visited so far, so the depth of the circuit is not bounded by that of
+// the call stack.
+void
+CirMgr::dfs(unsigned root, IdList& order)
+{
+    vector<pair<unsigned, int> > stack;
+    _aig.setMark(root);
+    if (_aig.getType(root) == UNDEF_GATE) return;
+    if (_aig.getType(root) != AIG_GATE) {
+        order.push_back(root);
+        return;
+    }
+    stack.push_back(make_pair(root, 0));
+    while (!stack.empty()) {
+        unsigned id = stack.back().first;
+        if (stack.back().second < 2) {
+            unsigned in = _aig.getFanin(id, stack.back().second++) / 2;
+            if (_aig.isMarked(in)) continue;
+            _aig.setMark(in);
+            GateType type = _aig.getType(in);
+            if (type == AIG_GATE) stack.push_back(make_pair(in, 0));
+            else if (type != UNDEF_GATE) order.push_back(in);
+            continue;
+        }
+        // both fanins are done, unless they are on a cycle
+        unsigned level = 1 + max(_levelList[_aig.getFanin(id, 0) / 2],
+                                 _levelList[_aig.getFanin(id, 1) / 2]);
+        _levelList[id] = level;
+        order.push_back(id);
+        stack.pop_back();
     }
 }
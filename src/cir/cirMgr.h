@@ -13,10 +13,22 @@
 #include <string>
 #include <fstream>
 #include <iostream>
+#include <thread>
+#include <atomic>
+#include <mutex>
+#include <climits>
 
 using namespace std;
 
 #include "cirDef.h"
+#include "cirModel.h"
+#include "cirCache.h"
+#include "cirAig.h"
+
+// A pass of simulation evaluates CIR_SIM_WORDS*64 patterns; -Random runs
+// CIR_SIM_PASSES passes
+#define CIR_SIM_WORDS   8
+#define CIR_SIM_PASSES  64
 
 extern CirMgr *cirMgr;
 
@@ -24,44 +36,235 @@ extern CirMgr *cirMgr;
 class CirMgr
 {
 public:
-    CirMgr() {}
+    CirMgr() : _modelSerial(0), _publishTime(0.0), _userMatrix(0), _movieMatrix(0),
+               _maxUserId(0), _maxMovieId(0), _users(0), _movies(0), _ratings(0),
+               _latent(200), _iterations(1000), _learningRate(0.01), _lambda(0.0),
+               _order(ORDER_USER), _seed(0), _target(0.0), _validRatio(0.0),
+               _split(SPLIT_RANDOM), _since(0), _until(UINT_MAX),
+               _ckptEvery(10), _resume(0), _streamBatch(256), _follow(false),
+               _publishEvery(100000), _quantize(false),
+               _trainThread(0), _stopRequest(false),
+               _maxLevel(0), _simLog(0), _fecInit(false),
+               _max(0), _pis(0), _pos(0), _aigs(0) {
+        _status._running = _status._stopped = _status._background = false;
+        _status._stream = false;
+        _status._epoch = 0;
+    }
     ~CirMgr();
     // Access functions
-    // return '0' if "gid" corresponds to an undefined gate.
-    CirGate* getGate(unsigned gid) const { return _totalList[gid]; }
-
-    void setPiGate(CirGate* pi, unsigned id) { _piList.push_back(pi); setGate(pi, id); }
-    void setPoGate(CirGate* po, unsigned id) { _poList.push_back(po); setGate(po, id); }
-    void setGate(CirGate* gate, unsigned id) { _totalList[id] = gate; }
-    void setNet(CirGate* gate) { _netList.push_back(gate); }
+    // A view of gate "gid"; see hasGate()
+    bool hasGate(unsigned gid) const { return _aig.exists(gid); }
+    CirGate getGate(unsigned gid) const;
+    int getMaxUserId() const { return _maxUserId; }
+    int getMaxMovieId() const { return _maxMovieId; }
+    int getRatings() const { return _ratings; }
+    int getLatent() const { return _latent; }
 
     // Member functions about circuit construction
-    bool readMatrix(const string&);
+    // Only ratings with "since" <= timestamp < "until" are read
+    void setTimeRange(unsigned since, unsigned until) {
+        _since = since; _until = until;
+    }
+    bool readMatrix(const string&);   // "-" reads stdin
+    bool readCircuit(const string&);  // an ASCII AIGER (.aag) file
+    bool hasCircuit() const { return _aig.size() != 0; }
+    void clearCircuit();
 
     // Member functions about circuit reporting
     void printSummary() const;
     void printSettings() const;
 
-    void train();
+    // Member functions about matrix factorization (in cirTrain.cpp)
+    void setIterations(int iters) { _iterations = iters; }
+    void setOrder(MatOrderType order) { _order = order; }
+    void setTarget(double rmse) { _target = rmse; }
+    void setValidRatio(double ratio) { _validRatio = ratio; }
+    void setSplit(MatSplitType split) { _split = split; }
+    void setLogFile(const string& file) { _logFile = file; }
+    void setCheckpoint(const string& file, int every) {
+        _ckptFile = file; _ckptEvery = every;
+    }
+    bool setResume(const string& file);
+    void initTraining();
+    void trainEpoch(int epoch);
+    void train(bool background = false);
+    bool isTrained() const { return _userMatrix != 0; }
+
+    // Member functions about online updates (in cirStream.cpp)
+    void setStream(int batch, bool follow) {
+        _streamBatch = batch; _follow = follow;
+    }
+    void setPublish(const string& file, int every) {
+        _publishFile = file; _publishEvery = every;
+    }
+    bool stream(const string& file);
+    bool streamBackground(const string& file);
+
+    // Member functions about background training (in cirTrain.cpp)
+    bool trainBackground();
+    bool stopTraining();
+    bool isTraining() const;
+    void printStatus() const;
+
+    // Member functions about recommendation (in cirRec.cpp). Queries read
+    // the last published model and never wait for training or updates.
+    bool predict(unsigned user, unsigned movie, double& score) const;
+    bool recommend(unsigned user, unsigned k, ScoreList& result,
+                   bool excludeRated = true) const;
+    bool hasModel() const { return !_model.empty(); }
+    bool loadModel(const string& file);   // in cirTrain.cpp
+    void publishModel(bool online = false);
+    // Models published from now on carry an int8 copy of the movie rows
+    void setQuantize(bool quantize) { _quantize = quantize; }
+    bool getQuantize() const { return _quantize; }
+
+    // Member functions about item similarity (in cirSimilar.cpp)
+    bool buildSimilar(unsigned n, bool cosine, int threads);
+    bool similar(unsigned movie, unsigned k, ScoreList& result) const;
+    bool hasSimilar() const { return atomic_load(&_simTable) != 0; }
+
+    // Member functions about the recommendation cache (in cirCache.cpp)
+    void setCacheSize(size_t bytes) { _recCache.setCapacity(bytes); }
+    size_t getCacheSize() const { return _recCache.getCapacity(); }
+    void getCacheStats(MatCacheStats& stats) const {
+        _recCache.getStats(stats);
+    }
 
     void printPIs() const;
     void printPOs() const;
     void printFloatGates() const;
     void writeAag(ostream&) const;
+    bool writeAig(ostream&) const;   // binary AIGER
     void traversal();
+    // AIGs count 1, PIs and constants 0; a PO is at the level of its fanin
+    unsigned getLevel(unsigned gid) const { return _levelList[gid]; }
+    unsigned getMaxLevel() const { return _maxLevel; }
+    const IdList& getNetList() const { return _netList; }
+
+    // Member functions about circuit simulation (in cirSim.cpp)
+    size_t randomSim(unsigned passes = CIR_SIM_PASSES);
+    bool fileSim(istream& patternFile, size_t& patterns);
+    // Each simulated pattern is logged as "<PI bits> <PO bits>"
+    void setSimLog(ofstream* logFile) { _simLog = logFile; }
+    // Groups of CONST 0 and the AIGs whose signatures so far are equal or
+    // complementary, refined by every pass of simulation
+    void printFECPairs() const;
+
+    // Member functions about optimization (in cirOpt.cpp); each returns
+    // the AIGs removed
+    unsigned sweep();      // of the AIGs no PO reaches
+    unsigned optimize();   // of the constant folding of trivial AIGs
+
+    // Member functions about cones (in cirCone.cpp)
+    // A new circuit of the transitive fanin cone of "gates", whose POs
+    // they are, or of their fanout cone, cut at the fanins from outside
+    // into PIs. The gates are renumbered; the CirMgr is the caller's.
+    CirMgr* extractCone(const IdList& gates, bool fanout) const;
+
+    // Member functions about fraig (in cirFraig.cpp)
+    // Merge the netlist AIGs with the same fanins; returns the AIGs removed
+    unsigned strash();
+    // Merge the FEC candidates proven equivalent by SAT, then strash();
+    // returns the AIGs removed
+    unsigned fraig();
 
 private:
-    double** _ratingMatrix;
-    double** _userMatrix;
-    double** _movieMatrix;
+    RatingList _ratingList;   // all ratings, in file order
+    IdList _timeList;         // timestamp of each rating in _ratingList
+    RatingList _trainList;    // ratings in the visiting order of an epoch
+    RatingList _validList;    // ratings held out from training
+    vector<size_t> _tileList; // tile boundaries in _trainList (ORDER_BLOCK)
+    shared_ptr<const MatIndex> _index;  // rated movies of each user
+    MatModelHandle _model;    // what predict() and recommend() read
+    unsigned long long _modelSerial;  // of the last published model
+    double _publishTime;      // wall time of the last publishModel()
+    mutable MatRecCache _recCache;    // results of recommend()
+    shared_ptr<const MatSimTable> _simTable;  // see buildSimilar()
+    IdList _touchedUsers;     // updated online since the last publish
+    double** _userMatrix;     // [_maxUserId+1][_latent]
+    double** _movieMatrix;    // [_maxMovieId+1][_latent]
+    // written under _statusMutex, as a stream may change them in background
     int _maxUserId, _maxMovieId, _users, _movies, _ratings;
     int _latent, _iterations;
     double _learningRate, _lambda;
+    MatOrderType _order;
+    unsigned _seed;
+    double _target;
+    double _validRatio;
+    MatSplitType _split;
+    unsigned _since, _until;
+    string _logFile;          // per-epoch JSON lines, if not empty
+    string _ckptFile;         // checkpoint every _ckptEvery epochs, if set
+    int _ckptEvery;
+    MatCkpt* _resume;         // consumed by the next train()
+    int _streamBatch;         // events per micro-batch of stream()
+    bool _follow;             // keep reading at the end of the feed
+    string _publishFile;      // snapshot every _publishEvery events, if set
+    int _publishEvery;
+    bool _quantize;           // see setQuantize()
+
+    // Progress of the latest training run; written by the training thread
+    // under _statusMutex at every epoch boundary
+    struct TrainStatus {
+        bool   _running, _stopped, _background, _stream;
+        int    _firstEpoch, _epoch, _bestEpoch;
+        double _loss, _rmse, _validRmse, _bestRmse;
+        double _start, _elapse;       // wall time
+        long long _events;            // applied by stream()
+    };
+    thread* _trainThread;
+    atomic<bool> _stopRequest;
+    mutable mutex _statusMutex;
+    TrainStatus _status;
+    vector<double> _bestUser, _bestMovie;   // factors of _status._bestEpoch
+
+    void buildTrainList();
+    void orderRatings(int epoch);
+    double trainError(double& rmse) const;
+    double validError() const;
+    void clearFactors();
+    void runStream(MatInput* in, bool background);
+    double applyBatch(const RatingList& batch, const IdList& times);
+    void growFactors(int maxUserId, int maxMovieId);
+    int resumeTraining();
+    void saveCheckpoint(int epoch, MatCkpt& ckpt) const;
+    void maybePublish(bool online = false);
+    void updateStatus(int epoch, double loss, double rmse, double validRmse);
+    void joinTraining();
+    void buildRatingIndex();
+    bool readCsv(MatInput&, const string&);
+    bool readBinary(MatInput&, const string&);
+    void countRatings();
+    bool parseCircuit(const char* data);
+    bool parseHeader(bool& binary);
+    bool parsePi();
+    bool parsePo(unsigned i);
+    bool parseAig();
+    bool parseDeltas(const char*& p);
+    bool parseSymbols(const char* p);
+    bool checkDef(unsigned lit, const char* type, const char* at);
+    void writeSymbols(ostream&) const;
+    void dfs(unsigned root, IdList& order);
+    void buildSimOps(IdList& ops);
+    void simulate(const IdList& ops);
+    void randomPis();
+    void simPass(const IdList& ops, unsigned patterns);
+    void logSim(unsigned patterns) const;
+    void refineFec();
+    void resetSim();
+    void mergeGate(unsigned id, unsigned lit);
+    unsigned satLit(SatSolver& solver, IdList& vars, unsigned lit);
+    void satCone(const IdList& vars, unsigned id, IdList& cone) const;
 
-    vector<CirGate*> _piList;
-    vector<CirGate*> _poList;
-    vector<CirGate*> _totalList;
-    vector<CirGate*> _netList;
+    CirAig _aig;
+    IdList _netList;          // topological, see traversal()
+    IdList _levelList;        // logic depth of each gate
+    unsigned _maxLevel;       // of the POs
+    // CIR_SIM_WORDS words per gate: the patterns of the last pass
+    vector<unsigned long long> _simValue;
+    ofstream* _simLog;
+    vector<IdList> _fecGrps;  // literals id*2+inv; inv per the signature
+    bool _fecInit;            // _fecGrps has been through a simulation
     vector<unsigned> _floatList;
     vector<unsigned> _unusedList;
     unsigned _max;
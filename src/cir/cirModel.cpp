@@ -0,0 +1,148 @@
+/****************************************************************************
+  FileName     [ cirModel.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define immutable model snapshots and their RCU handle ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <thread>
+#include <cassert>
+#include <cmath>
+#include "cirModel.h"
+
+using namespace std;
+
+/**************************************/
+/*   Static varaibles and functions   */
+/**************************************/
+// Epoch-based reclamation. A reader stores the epoch it entered at in its
+// slot (0 when outside). A writer retires the old model with the epoch
+// after its swap; a reader that entered at that epoch or later can only
+// have loaded the new model. All operations are sequentially consistent.
+static atomic<unsigned long long> rcuEpoch(1);
+static atomic<unsigned long long> rcuSlot[MAT_RCU_SLOTS];
+static atomic<bool>               rcuUsed[MAT_RCU_SLOTS];
+
+// The slot of a thread, claimed on its first read and freed at its exit
+struct MatRcuThread
+{
+   MatRcuThread() : _slot(-1), _depth(0) {}
+   ~MatRcuThread() { if (_slot >= 0) rcuUsed[_slot] = false; }
+
+   // The pools are bounded by MAT_RCU_POOL, so a slot is always free
+   int claim() {
+      for (int i = 0; i < MAT_RCU_SLOTS && _slot < 0; ++i) {
+         bool used = false;
+         if (rcuUsed[i].compare_exchange_strong(used, true)) _slot = i;
+      }
+      assert(_slot >= 0);
+      return _slot;
+   }
+
+   int _slot;
+   int _depth;     // nested sections share the outermost epoch
+};
+
+static thread_local MatRcuThread rcuThread;
+
+// The oldest epoch a reader is in, or 0 if there is none
+static unsigned long long
+oldestReader()
+{
+   unsigned long long oldest = 0;
+   for (int i = 0; i < MAT_RCU_SLOTS; ++i) {
+      unsigned long long e = rcuSlot[i].load();
+      if (e != 0 && (oldest == 0 || e < oldest)) oldest = e;
+   }
+   return oldest;
+}
+
+void
+matRcuEnter()
+{
+   if (rcuThread._depth++ == 0)
+      rcuSlot[rcuThread.claim()].store(rcuEpoch.load());
+}
+
+void
+matRcuExit()
+{
+   if (--rcuThread._depth == 0)
+      rcuSlot[rcuThread._slot].store(0);
+}
+
+/**************************************/
+/*   class MatModel functions         */
+/**************************************/
+MatModel::MatModel(unsigned long long serial, int latent, int maxUserId,
+                   int maxMovieId, const double* user, const double* movie,
+                   const shared_ptr<const MatIndex>& index)
+   : _serial(serial), _latent(latent), _maxUserId(maxUserId), _maxMovieId(maxMovieId),
+     _user(user, user + size_t(maxUserId + 1) * latent),
+     _movie(movie, movie + size_t(maxMovieId + 1) * latent), _index(index) {}
+
+// Each row gets its own scale, so |m[k] - _qScale[m] * q[k]| <= _qScale[m]/2
+void
+MatModel::quantize()
+{
+   size_t movies = size_t(_maxMovieId) + 1;
+   _qMovie.resize(movies * _latent);
+   _qScale.resize(movies);
+   _qL1.resize(movies);
+   for (size_t m = 0; m < movies; ++m) {
+      const double* row = &_movie[m * _latent];
+      double maxAbs = 0.0, l1 = 0.0;
+      for (int k = 0; k < _latent; ++k) {
+         maxAbs = max(maxAbs, fabs(row[k]));
+         l1 += fabs(row[k]);
+      }
+      double scale = maxAbs / 127;
+      signed char* q = &_qMovie[m * _latent];
+      for (int k = 0; k < _latent; ++k)
+         q[k] = scale > 0 ? (signed char)lround(row[k] / scale) : 0;
+      _qScale[m] = scale;
+      _qL1[m] = l1;
+   }
+}
+
+/**************************************/
+/*   class MatModelHandle functions   */
+/**************************************/
+// The owner must not be read any more; a reader on another thread that
+// is still inside its section is waited for
+MatModelHandle::~MatModelHandle()
+{
+   publish(0);
+   reclaim(true);
+}
+
+void
+MatModelHandle::publish(MatModel* model)
+{
+   MatModel* old = _model.exchange(model);
+   unsigned long long epoch = rcuEpoch.fetch_add(1) + 1;
+   lock_guard<mutex> lock(_retireMutex);
+   if (old) _retired.push_back(make_pair(old, epoch));
+   reclaim(false);
+}
+
+// Free the retired models no reader can see; with "wait", until all are
+void
+MatModelHandle::reclaim(bool wait)
+{
+   if (wait) _retireMutex.lock();
+   while (!_retired.empty()) {
+      unsigned long long oldest = oldestReader();
+      size_t kept = 0;
+      for (size_t i = 0; i < _retired.size(); ++i) {
+         if (oldest == 0 || oldest >= _retired[i].second)
+            delete _retired[i].first;
+         else _retired[kept++] = _retired[i];
+      }
+      _retired.resize(kept);
+      if (!wait) break;
+      this_thread::yield();
+   }
+   if (wait) _retireMutex.unlock();
+}
@@ -0,0 +1,129 @@
+/****************************************************************************
+  FileName     [ cirModel.h ]
+  PackageName  [ cir ]
+  Synopsis     [ Define immutable model snapshots and their RCU handle ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef CIR_MODEL_H
+#define CIR_MODEL_H
+
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <mutex>
+#include "cirDef.h"
+
+using namespace std;
+
+// Threads that may be inside a read-side section at the same time. A pool
+// of readers, as the workers of the server, may take up to MAT_RCU_POOL;
+// the others are for the shell, training and streaming threads.
+#define MAT_RCU_SLOTS  256
+#define MAT_RCU_POOL   (MAT_RCU_SLOTS - 16)
+
+// Movies rated by each user, to be skipped by recommendations
+struct MatIndex
+{
+   vector<size_t>  _userStart;   // _userMovies[_userStart[u].._userStart[u+1])
+   IdList          _userMovies;  // ascending per user
+   IdList          _movieIdList; // movies with at least one rating, ascending
+};
+
+// Nearest neighbors of each movie, best first: _movies[_start[m]..
+// _start[m+1]) with their similarities in _scores
+struct MatSimTable
+{
+   vector<size_t>  _start;     // _maxMovieId + 2 entries
+   IdList          _movies;
+   vector<float>   _scores;
+   bool            _cosine;
+};
+
+// A trained model frozen at one point. It is never changed after it is
+// published, so any number of threads may query it without locks.
+class MatModel
+{
+public:
+   MatModel(unsigned long long serial, int latent, int maxUserId,
+            int maxMovieId, const double* user, const double* movie,
+            const shared_ptr<const MatIndex>& index);
+
+   unsigned long long getSerial() const { return _serial; }
+   int getLatent() const { return _latent; }
+   int getMaxUserId() const { return _maxUserId; }
+   int getMaxMovieId() const { return _maxMovieId; }
+   const double* getUser(unsigned u) const { return &_user[size_t(u) * _latent]; }
+   const double* getMovie(unsigned m) const { return &_movie[size_t(m) * _latent]; }
+   const MatIndex& getIndex() const { return *_index; }
+
+   // Add an int8 copy of the movie rows for recommend(); only before the
+   // model is published
+   void quantize();
+   bool isQuantized() const { return !_qMovie.empty(); }
+
+   // in cirRec.cpp
+   bool predict(unsigned user, unsigned movie, double& score) const;
+   bool recommend(unsigned user, unsigned k, ScoreList& result,
+                  bool excludeRated) const;
+
+private:
+   unsigned long long           _serial;  // order of publication
+   int                          _latent;
+   int                          _maxUserId;
+   int                          _maxMovieId;
+   vector<double>               _user;
+   vector<double>               _movie;
+   shared_ptr<const MatIndex>   _index;   // may lag behind the factors
+   vector<signed char>          _qMovie;  // movie rows / _qScale, rounded
+   vector<double>               _qScale;  // of each movie row
+   vector<double>               _qL1;     // L1 norm of each movie row
+
+   void scanInt8(const double* u, unsigned k, size_t rated, size_t ratedEnd,
+                 ScoreList& result) const;
+};
+
+// The current MatModel of a CirMgr. Readers enter a read-side section with
+// MatModelReader and never wait; a writer swaps in a new model with one
+// atomic exchange, and the old one is freed once every reader that could
+// still see it has left.
+class MatModelHandle
+{
+public:
+   MatModelHandle() : _model(0) {}
+   ~MatModelHandle();
+
+   void publish(MatModel* model);   // takes the ownership
+   bool empty() const { return _model.load() == 0; }
+
+private:
+   friend class MatModelReader;
+
+   atomic<MatModel*>                           _model;
+   mutex                                       _retireMutex;
+   vector<pair<MatModel*, unsigned long long> > _retired;
+
+   MatModelHandle(const MatModelHandle&);   // not copyable
+   void reclaim(bool wait);
+};
+
+void matRcuEnter();
+void matRcuExit();
+
+// Scoped read-side section; get() stays valid until it is destroyed
+class MatModelReader
+{
+public:
+   MatModelReader(const MatModelHandle& handle) {
+      matRcuEnter(); _model = handle._model.load();
+   }
+   ~MatModelReader() { matRcuExit(); }
+
+   const MatModel* get() const { return _model; }
+
+private:
+   const MatModel* _model;
+};
+
+#endif // CIR_MODEL_H
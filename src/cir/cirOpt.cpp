@@ -0,0 +1,70 @@
+/****************************************************************************
+  FileName     [ cirOpt.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define cir optimization functions ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <vector>
+#include "cirMgr.h"
+#include "util.h"
+
+using namespace std;
+
+/**************************************************/
+/*   Public member functions about optimization   */
+/**************************************************/
+// Remove the AIGs that no PO reaches, i.e. those out of _netList. Their
+// fanins drop them in place, so the fanouts stay valid; an UNDEF gate
+// left without fanouts is gone as well.
+unsigned
+CirMgr::sweep()
+{
+    const IdList& aigList = _aig.getAigList();
+    _aig.newMark();
+    for (size_t i = 0; i < _netList.size(); ++i) _aig.setMark(_netList[i]);
+    unsigned removed = 0;
+    for (size_t i = 0; i < aigList.size(); ++i) {
+        unsigned id = aigList[i];
+        if (_aig.isMarked(id) || _aig.getType(id) != AIG_GATE) continue;
+        for (int j = 0; j < 2; ++j)
+            _aig.removeFanout(_aig.getFanin(id, j) / 2, id);
+        _aig.removeAig(id);
+        ++removed;
+    }
+    if (removed) {
+        _aigs -= removed;
+        _aig.compactAigList();
+        traversal();   // for the floating and unused gates
+    }
+    return removed;
+}
+
+// Fold the AIGs of a constant or repeated fanin: x&0 and x&!x become
+// CONST 0, x&1 and x&x become x. In _netList order the fanins of an AIG
+// are final when it is visited, so a gate is only merged into one that
+// stays. The fanins left unused are for sweep().
+unsigned
+CirMgr::optimize()
+{
+    unsigned removed = 0;
+    for (size_t i = 0; i < _netList.size(); ++i) {
+        unsigned id = _netList[i];
+        if (_aig.getType(id) != AIG_GATE) continue;
+        unsigned a = _aig.getFanin(id, 0), b = _aig.getFanin(id, 1), lit;
+        if (a == 0 || b == 0 || a == (b ^ 1)) lit = 0;
+        else if (a == 1 || a == b) lit = b;
+        else if (b == 1) lit = a;
+        else continue;
+        mergeGate(id, lit);
+        ++removed;
+    }
+    if (removed) {
+        _aigs -= removed;
+        _aig.buildFanouts();
+        traversal();
+        resetSim();
+    }
+    return removed;
+}
@@ -0,0 +1,256 @@
+/****************************************************************************
+  FileName     [ cirRec.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define prediction and top-K recommendation queries ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include "cirMgr.h"
+#include "cirKernel.h"
+#include "util.h"
+
+using namespace std;
+
+// Seconds between two models published by a running writer
+#define MAT_PUBLISH_SEC  1.0
+// Movies rescored exactly per recommended movie before the error bounds
+// are checked (see MatModel::scanInt8())
+#define MAT_REC_OVERFETCH  4
+
+/**************************************/
+/*   Static varaibles and functions   */
+/**************************************/
+// Order for a min-heap on score: the worst of the current top K at front
+struct ScoreGreater
+{
+    bool operator() (const MovieScore& a, const MovieScore& b) const {
+        return a._score != b._score ? a._score > b._score : a._movie < b._movie;
+    }
+};
+
+/*******************************************************/
+/*   class MatModel member functions                   */
+/*******************************************************/
+bool
+MatModel::predict(unsigned user, unsigned movie, double& score) const
+{
+    if (user > unsigned(_maxUserId) || movie > unsigned(_maxMovieId))
+        return false;
+    score = matDot(getUser(user), getMovie(movie), _latent);
+    return true;
+}
+
+// Return the "k" best scored movies for "user", best first. Rated movies
+// are skipped in O(1) amortized while the movies are scanned in ascending
+// order; users and movies newer than the index are not filtered.
+bool
+MatModel::recommend(unsigned user, unsigned k, ScoreList& result,
+                    bool excludeRated) const
+{
+    result.clear();
+    if (user > unsigned(_maxUserId)) return false;
+    if (k == 0) return true;
+
+    const double* u = getUser(user);
+    const IdList& movies = _index->_movieIdList;
+    const IdList& userMovies = _index->_userMovies;
+    size_t rated = 0, ratedEnd = 0;
+    if (excludeRated && user + 1 < _index->_userStart.size()) {
+        rated = _index->_userStart[user];
+        ratedEnd = _index->_userStart[user+1];
+    }
+    ScoreGreater cmp;
+    result.reserve(k + 1);
+    if (isQuantized()) {
+        scanInt8(u, k, rated, ratedEnd, result);
+        return true;
+    }
+    for (size_t i = 0, n = movies.size(); i < n; ++i) {
+        unsigned movie = movies[i];
+        if (movie > unsigned(_maxMovieId)) break;
+        while (rated < ratedEnd && userMovies[rated] < movie) ++rated;
+        if (rated < ratedEnd && userMovies[rated] == movie) continue;
+        MovieScore ms = { movie, matDot(u, getMovie(movie), _latent) };
+        if (result.size() < k) {
+            result.push_back(ms);
+            push_heap(result.begin(), result.end(), cmp);
+        }
+        else if (cmp(ms, result.front())) {
+            pop_heap(result.begin(), result.end(), cmp);
+            result.back() = ms;
+            push_heap(result.begin(), result.end(), cmp);
+        }
+    }
+    sort_heap(result.begin(), result.end(), cmp);
+    return true;
+}
+
+// Keep "ms" if it is among the "k" best in the min-heap "result"
+static inline void
+pushScore(ScoreList& result, unsigned k, const MovieScore& ms)
+{
+    ScoreGreater cmp;
+    if (result.size() < k) {
+        result.push_back(ms);
+        push_heap(result.begin(), result.end(), cmp);
+    }
+    else if (cmp(ms, result.front())) {
+        pop_heap(result.begin(), result.end(), cmp);
+        result.back() = ms;
+        push_heap(result.begin(), result.end(), cmp);
+    }
+}
+
+// The same result as the exact scan, read mostly from the int8 table. The
+// user row is quantized too; an approximate score then differs from the
+// exact one by at most (su * |m|_1 + sm * |u'|_1) / 2. All movies are
+// scored approximately, the best MAT_REC_OVERFETCH * k are rescored
+// exactly, and so is any other movie whose bound reaches the k-th exact
+// score found so far.
+void
+MatModel::scanInt8(const double* u, unsigned k, size_t rated,
+                   size_t ratedEnd, ScoreList& result) const
+{
+    static thread_local vector<signed char> qu;
+    static thread_local ScoreList approx;
+    double maxAbs = 0.0;
+    for (int j = 0; j < _latent; ++j) maxAbs = max(maxAbs, fabs(u[j]));
+    double su = maxAbs / 127, ul1 = 0.0;
+    qu.resize(_latent);
+    for (int j = 0; j < _latent; ++j) {
+        qu[j] = su > 0 ? (signed char)lround(u[j] / su) : 0;
+        ul1 += su * abs(qu[j]);
+    }
+
+    const IdList& movies = _index->_movieIdList;
+    const IdList& userMovies = _index->_userMovies;
+    approx.clear();
+    for (size_t i = 0, n = movies.size(); i < n; ++i) {
+        unsigned movie = movies[i];
+        if (movie > unsigned(_maxMovieId)) break;
+        while (rated < ratedEnd && userMovies[rated] < movie) ++rated;
+        if (rated < ratedEnd && userMovies[rated] == movie) continue;
+        int dot = matDotInt8(&qu[0], &_qMovie[size_t(movie) * _latent],
+                             _latent);
+        MovieScore ms = { movie, su * _qScale[movie] * dot };
+        approx.push_back(ms);
+    }
+
+    ScoreGreater cmp;
+    size_t head = min(approx.size(), size_t(k) * MAT_REC_OVERFETCH);
+    nth_element(approx.begin(), approx.begin() + head, approx.end(), cmp);
+    for (size_t i = 0; i < head; ++i) {
+        unsigned movie = approx[i]._movie;
+        MovieScore ms = { movie, matDot(u, getMovie(movie), _latent) };
+        pushScore(result, k, ms);
+    }
+    for (size_t i = head, n = approx.size(); i < n; ++i) {
+        unsigned movie = approx[i]._movie;
+        if (result.size() == k) {
+            // a little slack for the rounding of the bound itself
+            double bound = 0.5 * (su * _qL1[movie] + _qScale[movie] * ul1);
+            if (approx[i]._score + bound * (1 + 1e-9) + 1e-12 <
+                result.front()._score)
+                continue;
+        }
+        MovieScore ms = { movie, matDot(u, getMovie(movie), _latent) };
+        pushScore(result, k, ms);
+    }
+    sort_heap(result.begin(), result.end(), cmp);
+}
+
+/*******************************************************/
+/*   class CirMgr member functions for recommendation  */
+/*******************************************************/
+// Index the ratings by user. A new index is built each time, as published
+// models may still share the old one.
+void
+CirMgr::buildRatingIndex()
+{
+    MatIndex* index = new MatIndex;
+    vector<size_t>& userStart = index->_userStart;
+    userStart.assign(_maxUserId+2, 0);
+    for (size_t r = 0, n = _ratingList.size(); r < n; ++r)
+        ++userStart[_ratingList[r]._user+1];
+    for (int u = 0; u <= _maxUserId; ++u)
+        userStart[u+1] += userStart[u];
+
+    vector<size_t> pos(userStart.begin(), userStart.end() - 1);
+    vector<bool> movieExist(_maxMovieId+1, false);
+    index->_userMovies.resize(_ratingList.size());
+    for (size_t r = 0, n = _ratingList.size(); r < n; ++r) {
+        const Rating& rt = _ratingList[r];
+        index->_userMovies[pos[rt._user]++] = rt._movie;
+        movieExist[rt._movie] = true;
+    }
+    for (int u = 0; u <= _maxUserId; ++u)
+        sort(index->_userMovies.begin() + userStart[u],
+             index->_userMovies.begin() + userStart[u+1]);
+
+    for (int j = 0; j <= _maxMovieId; ++j)
+        if (movieExist[j]) index->_movieIdList.push_back(j);
+    _index.reset(index);
+}
+
+// Freeze the current factors into a new model for the readers. Cached
+// recommendations are dropped first, so that none computed on an older
+// model is returned afterwards. After "online" updates only the users
+// whose rows changed are dropped; the others keep results that miss the
+// small drift of the movie rows until the next full publish.
+void
+CirMgr::publishModel(bool online)
+{
+    if (!isTrained()) return;
+    MyUsagePhase phase(myUsage, "publish");
+    unsigned long long serial = ++_modelSerial;
+    if (online) {
+        sort(_touchedUsers.begin(), _touchedUsers.end());
+        _touchedUsers.erase(unique(_touchedUsers.begin(), _touchedUsers.end()),
+                            _touchedUsers.end());
+        for (size_t i = 0, n = _touchedUsers.size(); i < n; ++i)
+            _recCache.invalidate(_touchedUsers[i], serial);
+    }
+    else _recCache.invalidateAll(serial);
+    _touchedUsers.clear();
+    MatModel* model = new MatModel(serial, _latent, _maxUserId, _maxMovieId,
+                                   _userMatrix[0], _movieMatrix[0], _index);
+    if (_quantize) model->quantize();
+    _model.publish(model);
+    _publishTime = myUsage.getWallTime();
+}
+
+// Copying the factors costs about as much as a tenth of an epoch, so a
+// running writer publishes at most once per MAT_PUBLISH_SEC
+void
+CirMgr::maybePublish(bool online)
+{
+    if (_publishTime == 0.0 ||
+        myUsage.getWallTime() - _publishTime >= MAT_PUBLISH_SEC)
+        publishModel(online);
+}
+
+bool
+CirMgr::predict(unsigned user, unsigned movie, double& score) const
+{
+    MatModelReader reader(_model);
+    return reader.get() && reader.get()->predict(user, movie, score);
+}
+
+bool
+CirMgr::recommend(unsigned user, unsigned k, ScoreList& result,
+                  bool excludeRated) const
+{
+    MatModelReader reader(_model);
+    const MatModel* model = reader.get();
+    result.clear();
+    if (model == 0) return false;
+    if (_recCache.lookup(user, k, excludeRated, result)) return true;
+    if (!model->recommend(user, k, result, excludeRated)) return false;
+    if (_recCache.enabled())
+        _recCache.insert(user, k, excludeRated, model->getSerial(), result);
+    return true;
+}
@@ -0,0 +1,474 @@
+/****************************************************************************
+  FileName     [ cirSat.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define an incremental SAT solver for FRAIG ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <cstdlib>
+#include <algorithm>
+#include "cirSat.h"
+
+using namespace std;
+
+// Conflicts of the first restart, scaled by the Luby sequence
+#define SAT_RESTART_BASE  100
+#define SAT_VAR_DECAY     0.95
+#define SAT_CLA_DECAY     0.999
+
+struct SatClause
+{
+   unsigned  _size;
+   bool      _learnt;
+   bool      _deleted;
+   float     _act;
+   SatLit    _lits[1];   // _size of them; [0] is implied by a reason
+};
+
+/**************************************/
+/*   Static varaibles and functions   */
+/**************************************/
+// 1, 1, 2, 1, 1, 2, 4, 1, ...
+static unsigned
+luby(unsigned i)
+{
+   unsigned size = 1, seq = 0;
+   while (size < i + 1) { ++seq; size = 2 * size + 1; }
+   while (size - 1 != i) {
+      size = (size - 1) >> 1;
+      --seq;
+      i = i % size;
+   }
+   return 1u << seq;
+}
+
+static bool
+lessActive(const SatClause* a, const SatClause* b)
+{
+   return a->_act < b->_act;
+}
+
+/****************************************/
+/*   class SatSolver member functions   */
+/****************************************/
+SatSolver::SatSolver()
+   : _qhead(0), _varInc(1.0), _claInc(1.0), _maxLearnts(4000), _ok(true),
+     _conflicts(0), _decisions(0)
+{
+}
+
+void
+SatSolver::reset()
+{
+   for (size_t i = 0; i < _clauses.size(); ++i) free(_clauses[i]);
+   for (size_t i = 0; i < _learnts.size(); ++i) free(_learnts[i]);
+   _clauses.clear(); _learnts.clear();
+   _value.clear(); _level.clear(); _reason.clear(); _phase.clear();
+   _seen.clear(); _decision.clear(); _activity.clear();
+   _heap.clear(); _heapIdx.clear();
+   _trail.clear(); _trailLim.clear(); _qhead = 0;
+   _watches.clear(); _model.clear();
+   _varInc = _claInc = 1.0;
+   _maxLearnts = 4000;
+   _ok = true;
+}
+
+unsigned
+SatSolver::newVar(bool decision)
+{
+   unsigned v = _value.size();
+   _value.push_back(2);
+   _level.push_back(0);
+   _reason.push_back(0);
+   _phase.push_back(0);
+   _seen.push_back(0);
+   _decision.push_back(decision);
+   _activity.push_back(0.0);
+   _heapIdx.push_back(-1);
+   _model.push_back(0);
+   _watches.resize(2 * size_t(v) + 2);
+   if (decision) heapInsert(v);
+   return v;
+}
+
+void
+SatSolver::setDecision(unsigned var, bool decision)
+{
+   _decision[var] = decision;
+   if (decision && _value[var] == 2) heapInsert(var);
+}
+
+// At level 0: false literals are dropped, and a unit is propagated
+bool
+SatSolver::addClause(const vector<SatLit>& lits)
+{
+   if (!_ok) return false;
+   vector<SatLit> c(lits);
+   sort(c.begin(), c.end());
+   size_t n = 0;
+   for (size_t i = 0; i < c.size(); ++i) {
+      unsigned char v = litValue(c[i]);
+      if (v == 1 || (n && c[i] == (c[n-1] ^ 1))) return true;
+      if (v == 0 || (n && c[i] == c[n-1])) continue;
+      c[n++] = c[i];
+   }
+   c.resize(n);
+   if (n == 0) return _ok = false;
+   if (n == 1) {
+      enqueue(c[0], 0);
+      return _ok = (propagate() == 0);
+   }
+   SatClause* cl = newClause(c, false);
+   _clauses.push_back(cl);
+   attach(cl);
+   return true;
+}
+
+bool
+SatSolver::addClause(SatLit a)
+{
+   return addClause(vector<SatLit>(1, a));
+}
+
+bool
+SatSolver::addClause(SatLit a, SatLit b)
+{
+   vector<SatLit> c(2);
+   c[0] = a; c[1] = b;
+   return addClause(c);
+}
+
+bool
+SatSolver::addClause(SatLit a, SatLit b, SatLit c)
+{
+   vector<SatLit> cl(3);
+   cl[0] = a; cl[1] = b; cl[2] = c;
+   return addClause(cl);
+}
+
+void
+SatSolver::addAnd(SatLit out, SatLit a, SatLit b)
+{
+   addClause(out ^ 1, a);
+   addClause(out ^ 1, b);
+   addClause(out, a ^ 1, b ^ 1);
+}
+
+void
+SatSolver::addXor(SatLit out, SatLit a, SatLit b)
+{
+   addClause(out ^ 1, a, b);
+   addClause(out ^ 1, a ^ 1, b ^ 1);
+   addClause(out, a ^ 1, b);
+   addClause(out, a, b ^ 1);
+}
+
+// Assumptions are decided first, one per level. Learnt clauses follow
+// from the clauses alone, so they are kept for the later calls.
+SatStatus
+SatSolver::solve(const vector<SatLit>& assumps, unsigned conflicts)
+{
+   if (!_ok) return SAT_UNSAT;
+   unsigned long long limit = conflicts ? _conflicts + conflicts : 0;
+   unsigned restarts = 0, untilRestart = SAT_RESTART_BASE * luby(0);
+   vector<SatLit> learnt;
+   for (;;) {
+      SatClause* confl = propagate();
+      if (confl != 0) {
+         ++_conflicts;
+         if (untilRestart) --untilRestart;
+         if (decisionLevel() == 0) { _ok = false; return SAT_UNSAT; }
+         unsigned level;
+         analyze(confl, learnt, level);
+         cancelUntil(level);
+         if (learnt.size() == 1)
+            enqueue(learnt[0], 0);
+         else {
+            SatClause* c = newClause(learnt, true);
+            _learnts.push_back(c);
+            attach(c);
+            bumpClause(c);
+            enqueue(learnt[0], c);
+         }
+         _varInc /= SAT_VAR_DECAY;
+         _claInc /= SAT_CLA_DECAY;
+         continue;
+      }
+      if (limit && _conflicts >= limit) {
+         cancelUntil(0);
+         return SAT_UNKNOWN;
+      }
+      if (untilRestart == 0) {
+         cancelUntil(0);
+         untilRestart = SAT_RESTART_BASE * luby(++restarts);
+         if (_learnts.size() >= _maxLearnts) reduceLearnts();
+         continue;
+      }
+      SatLit next = SatLit(-1);
+      while (decisionLevel() < assumps.size()) {
+         SatLit p = assumps[decisionLevel()];
+         unsigned char v = litValue(p);
+         if (v == 1) _trailLim.push_back(_trail.size());
+         else if (v == 0) { cancelUntil(0); return SAT_UNSAT; }
+         else { next = p; break; }
+      }
+      if (next == SatLit(-1)) {
+         int v = pickBranch();
+         if (v < 0) {
+            for (size_t i = 0; i < _value.size(); ++i)
+               _model[i] = _value[i];
+            cancelUntil(0);
+            return SAT_SAT;
+         }
+         next = 2 * unsigned(v) + (_phase[v] ? 0 : 1);
+         ++_decisions;
+      }
+      _trailLim.push_back(_trail.size());
+      enqueue(next, 0);
+   }
+}
+
+SatClause*
+SatSolver::newClause(const vector<SatLit>& lits, bool learnt)
+{
+   SatClause* c = (SatClause*)malloc(sizeof(SatClause) +
+                                     (lits.size() - 1) * sizeof(SatLit));
+   c->_size = lits.size();
+   c->_learnt = learnt;
+   c->_deleted = false;
+   c->_act = 0.0f;
+   for (size_t i = 0; i < lits.size(); ++i) c->_lits[i] = lits[i];
+   return c;
+}
+
+void
+SatSolver::attach(SatClause* c)
+{
+   SatWatch w0 = { c, c->_lits[1] }, w1 = { c, c->_lits[0] };
+   _watches[c->_lits[0]].push_back(w0);
+   _watches[c->_lits[1]].push_back(w1);
+}
+
+void
+SatSolver::enqueue(SatLit l, SatClause* reason)
+{
+   unsigned v = l >> 1;
+   _value[v] = (l & 1) ^ 1;
+   _level[v] = decisionLevel();
+   _reason[v] = reason;
+   _trail.push_back(l);
+}
+
+// The conflicting clause, or 0
+SatClause*
+SatSolver::propagate()
+{
+   while (_qhead < _trail.size()) {
+      SatLit falseLit = _trail[_qhead++] ^ 1;
+      vector<SatWatch>& ws = _watches[falseLit];
+      size_t i = 0, j = 0, n = ws.size();
+      while (i < n) {
+         if (litValue(ws[i]._blocker) == 1) { ws[j++] = ws[i++]; continue; }
+         SatClause* c = ws[i]._clause;
+         SatLit* lits = c->_lits;
+         if (lits[0] == falseLit) { lits[0] = lits[1]; lits[1] = falseLit; }
+         ++i;
+         SatWatch w = { c, lits[0] };
+         if (litValue(lits[0]) == 1) { ws[j++] = w; continue; }
+         bool moved = false;
+         for (unsigned k = 2; k < c->_size; ++k)
+            if (litValue(lits[k]) != 0) {
+               lits[1] = lits[k]; lits[k] = falseLit;
+               _watches[lits[1]].push_back(w);
+               moved = true;
+               break;
+            }
+         if (moved) continue;
+         ws[j++] = w;
+         if (litValue(lits[0]) == 0) {
+            while (i < n) ws[j++] = ws[i++];
+            ws.resize(j);
+            _qhead = _trail.size();
+            return c;
+         }
+         enqueue(lits[0], c);
+      }
+      ws.resize(j);
+   }
+   return 0;
+}
+
+// 1-UIP clause of "confl" into "learnt", the asserting literal first and
+// a literal of the backtrack "level" second
+void
+SatSolver::analyze(SatClause* confl, vector<SatLit>& learnt, unsigned& level)
+{
+   learnt.assign(1, 0);
+   int pathC = 0;
+   SatLit p = SatLit(-1);
+   size_t idx = _trail.size();
+   do {
+      if (confl->_learnt) bumpClause(confl);
+      for (unsigned j = (p == SatLit(-1) ? 0 : 1); j < confl->_size; ++j) {
+         SatLit q = confl->_lits[j];
+         unsigned v = q >> 1;
+         if (_seen[v] || _level[v] == 0) continue;
+         bumpVar(v);
+         _seen[v] = 1;
+         if (_level[v] >= decisionLevel()) ++pathC;
+         else learnt.push_back(q);
+      }
+      while (!_seen[_trail[--idx] >> 1]) ;
+      p = _trail[idx];
+      confl = _reason[p >> 1];
+      _seen[p >> 1] = 0;
+   } while (--pathC > 0);
+   learnt[0] = p ^ 1;
+
+   // drop the literals implied by the others
+   vector<SatLit> all(learnt);
+   size_t n = 1;
+   for (size_t i = 1; i < learnt.size(); ++i) {
+      SatClause* r = _reason[learnt[i] >> 1];
+      bool redundant = (r != 0);
+      for (unsigned k = 1; redundant && k < r->_size; ++k) {
+         unsigned v = r->_lits[k] >> 1;
+         if (!_seen[v] && _level[v] > 0) redundant = false;
+      }
+      if (!redundant) learnt[n++] = learnt[i];
+   }
+   learnt.resize(n);
+   for (size_t i = 0; i < all.size(); ++i) _seen[all[i] >> 1] = 0;
+
+   level = 0;
+   for (size_t i = 1; i < learnt.size(); ++i)
+      if (_level[learnt[i] >> 1] > level) {
+         level = _level[learnt[i] >> 1];
+         swap(learnt[1], learnt[i]);
+      }
+}
+
+void
+SatSolver::cancelUntil(unsigned level)
+{
+   if (decisionLevel() <= level) return;
+   for (size_t i = _trail.size(); i > _trailLim[level]; --i) {
+      unsigned v = _trail[i - 1] >> 1;
+      _phase[v] = _value[v];
+      _value[v] = 2;
+      _reason[v] = 0;
+      if (_decision[v]) heapInsert(v);
+   }
+   _trail.resize(_trailLim[level]);
+   _trailLim.resize(level);
+   _qhead = _trail.size();
+}
+
+// An unassigned decision var of the highest activity, or -1
+int
+SatSolver::pickBranch()
+{
+   while (!_heap.empty()) {
+      unsigned v = heapPop();
+      if (_value[v] == 2 && _decision[v]) return v;
+   }
+   return -1;
+}
+
+// At level 0: the less active half of the long learnt clauses goes. The
+// reasons of level-0 vars are never read again, so they are cleared.
+void
+SatSolver::reduceLearnts()
+{
+   sort(_learnts.begin(), _learnts.end(), lessActive);
+   for (size_t i = 0; i < _learnts.size() / 2; ++i)
+      if (_learnts[i]->_size > 2) _learnts[i]->_deleted = true;
+   for (size_t l = 0; l < _watches.size(); ++l) {
+      vector<SatWatch>& ws = _watches[l];
+      size_t j = 0;
+      for (size_t i = 0; i < ws.size(); ++i)
+         if (!ws[i]._clause->_deleted) ws[j++] = ws[i];
+      ws.resize(j);
+   }
+   for (size_t i = 0; i < _trail.size(); ++i) _reason[_trail[i] >> 1] = 0;
+   size_t n = 0;
+   for (size_t i = 0; i < _learnts.size(); ++i)
+      if (_learnts[i]->_deleted) free(_learnts[i]);
+      else _learnts[n++] = _learnts[i];
+   _learnts.resize(n);
+   _maxLearnts += _maxLearnts / 10;
+}
+
+void
+SatSolver::bumpVar(unsigned v)
+{
+   if ((_activity[v] += _varInc) > 1e100) {
+      for (size_t i = 0; i < _activity.size(); ++i) _activity[i] *= 1e-100;
+      _varInc *= 1e-100;
+   }
+   if (_heapIdx[v] >= 0) heapUp(_heapIdx[v]);
+}
+
+void
+SatSolver::bumpClause(SatClause* c)
+{
+   if ((c->_act += float(_claInc)) > 1e20f) {
+      for (size_t i = 0; i < _learnts.size(); ++i) _learnts[i]->_act *= 1e-20f;
+      _claInc *= 1e-20;
+   }
+}
+
+void
+SatSolver::heapInsert(unsigned v)
+{
+   if (_heapIdx[v] >= 0) return;
+   _heapIdx[v] = _heap.size();
+   _heap.push_back(v);
+   heapUp(_heapIdx[v]);
+}
+
+void
+SatSolver::heapUp(int i)
+{
+   unsigned v = _heap[i];
+   while (i > 0) {
+      int parent = (i - 1) / 2;
+      if (_activity[_heap[parent]] >= _activity[v]) break;
+      _heap[i] = _heap[parent];
+      _heapIdx[_heap[i]] = i;
+      i = parent;
+   }
+   _heap[i] = v;
+   _heapIdx[v] = i;
+}
+
+void
+SatSolver::heapDown(int i)
+{
+   unsigned v = _heap[i];
+   int n = _heap.size();
+   for (int child; (child = 2 * i + 1) < n; i = child) {
+      if (child + 1 < n &&
+          _activity[_heap[child + 1]] > _activity[_heap[child]]) ++child;
+      if (_activity[_heap[child]] <= _activity[v]) break;
+      _heap[i] = _heap[child];
+      _heapIdx[_heap[i]] = i;
+   }
+   _heap[i] = v;
+   _heapIdx[v] = i;
+}
+
+unsigned
+SatSolver::heapPop()
+{
+   unsigned v = _heap[0];
+   _heapIdx[v] = -1;
+   _heap[0] = _heap.back();
+   _heap.pop_back();
+   if (!_heap.empty()) {
+      _heapIdx[_heap[0]] = 0;
+      heapDown(0);
+   }
+   return v;
+}
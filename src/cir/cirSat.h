@@ -0,0 +1,117 @@
+/****************************************************************************
+  FileName     [ cirSat.h ]
+  PackageName  [ cir ]
+  Synopsis     [ Define an incremental SAT solver for FRAIG ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef CIR_SAT_H
+#define CIR_SAT_H
+
+#include <vector>
+
+using namespace std;
+
+// A literal is var*2+inv, as a literal of an AIG
+typedef unsigned SatLit;
+
+enum SatStatus
+{
+   SAT_UNSAT,
+   SAT_SAT,
+   SAT_UNKNOWN   // the conflict budget ran out
+};
+
+struct SatClause;
+
+struct SatWatch
+{
+   SatClause*  _clause;
+   SatLit      _blocker;   // if true, the clause is satisfied
+};
+
+// A CDCL solver: two watched literals, 1-UIP learning, VSIDS, phase
+// saving and Luby restarts. Clauses may be added between calls of
+// solve(), each of which takes its own assumptions.
+class SatSolver
+{
+public:
+   SatSolver();
+   ~SatSolver() { reset(); }
+
+   void reset();   // no vars and no clauses; the counts stay
+
+   unsigned newVar(bool decision = true);
+   unsigned getNumVars() const { return _value.size(); }
+   // Only decision vars are branched on. If every clause with a var left
+   // undecided can be satisfied by any values of the others, as with the
+   // Tseitin clauses of the fanouts of a cone, SAT_SAT stays sound.
+   void setDecision(unsigned var, bool decision);
+
+   // false if the clauses are now unsatisfiable
+   bool addClause(const vector<SatLit>& lits);
+   bool addClause(SatLit a);
+   bool addClause(SatLit a, SatLit b);
+   bool addClause(SatLit a, SatLit b, SatLit c);
+   // Tseitin clauses of out = a & b, and of out = a ^ b
+   void addAnd(SatLit out, SatLit a, SatLit b);
+   void addXor(SatLit out, SatLit a, SatLit b);
+
+   // "conflicts" of 0 is no limit
+   SatStatus solve(const vector<SatLit>& assumps, unsigned conflicts = 0);
+   // Of the last SAT_SAT: 0, 1, or 2 if "var" was left unassigned
+   unsigned char getValue(unsigned var) const { return _model[var]; }
+
+   unsigned long long getConflicts() const { return _conflicts; }
+   unsigned long long getDecisions() const { return _decisions; }
+
+private:
+   vector<unsigned char>     _value;      // per var: 0, 1, or 2 unassigned
+   vector<unsigned>          _level;
+   vector<SatClause*>        _reason;
+   vector<unsigned char>     _phase;      // last value, for decisions
+   vector<unsigned char>     _seen;
+   vector<unsigned char>     _decision;
+   vector<double>            _activity;
+   vector<unsigned>          _heap;       // vars by _activity, max first
+   vector<int>               _heapIdx;    // -1 if not in _heap
+   vector<SatLit>            _trail;
+   vector<size_t>            _trailLim;   // _trail size at each level
+   size_t                    _qhead;
+   vector<vector<SatWatch> > _watches;    // per literal, seen when false
+   vector<SatClause*>        _clauses;
+   vector<SatClause*>        _learnts;
+   vector<unsigned char>     _model;
+   double                    _varInc;
+   double                    _claInc;
+   size_t                    _maxLearnts;
+   bool                      _ok;
+   unsigned long long        _conflicts;
+   unsigned long long        _decisions;
+
+   // 0, 1, or 2 unassigned
+   unsigned char litValue(SatLit l) const {
+      unsigned char v = _value[l >> 1];
+      return v == 2 ? 2 : v ^ (l & 1);
+   }
+   unsigned decisionLevel() const { return _trailLim.size(); }
+
+   SatClause* newClause(const vector<SatLit>& lits, bool learnt);
+   void attach(SatClause* c);
+   void enqueue(SatLit l, SatClause* reason);
+   SatClause* propagate();
+   void analyze(SatClause* confl, vector<SatLit>& learnt, unsigned& level);
+   void cancelUntil(unsigned level);
+   int pickBranch();
+   void reduceLearnts();
+
+   void bumpVar(unsigned v);
+   void bumpClause(SatClause* c);
+   void heapInsert(unsigned v);
+   void heapUp(int i);
+   void heapDown(int i);
+   unsigned heapPop();
+};
+
+#endif // CIR_SAT_H
@@ -0,0 +1,557 @@
+/****************************************************************************
+  FileName     [ cirServe.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define the recommendation server and its line protocol ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <iostream>
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+#include <csignal>
+#include <cerrno>
+#include <deque>
+#include <map>
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <sys/epoll.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include "cirServe.h"
+#include "cirMgr.h"
+#include "util.h"
+
+using namespace std;
+
+#define MAT_SERVE_EVENTS      64
+#define MAT_SERVE_TIMEOUT_MS  200    // how soon a signal is noticed
+#define MAT_SERVE_LINE        4096   // longest request
+
+/**************************************/
+/*   class MatLatency functions       */
+/**************************************/
+static unsigned
+latBucket(unsigned long long v)
+{
+   if (v < 8) return v;
+   unsigned b = 63 - __builtin_clzll(v);
+   return (b - 2) * 8 + ((v >> (b - 3)) & 7);
+}
+
+// Middle of the range of bucket "i"
+static double
+latValue(unsigned i)
+{
+   if (i < 8) return i;
+   unsigned b = i / 8 + 2, sub = i % 8;
+   return ((8 + sub) * 2 + 1) * double(1ULL << (b - 3)) / 2;
+}
+
+void
+MatLatency::reset()
+{
+   for (int i = 0; i < MAT_LAT_BUCKETS; ++i) _count[i] = 0;
+   _total = 0;
+}
+
+void
+MatLatency::add(double us)
+{
+   ++_count[latBucket(us > 0 ? (unsigned long long)us : 0)];
+   ++_total;
+}
+
+double
+MatLatency::percentile(double p) const
+{
+   unsigned long long total = _total.load(), rank = ceil(p * total), sum = 0;
+   if (total == 0) return 0.0;
+   if (rank == 0) rank = 1;
+   for (int i = 0; i < MAT_LAT_BUCKETS; ++i)
+      if ((sum += _count[i].load()) >= rank) return latValue(i);
+   return latValue(MAT_LAT_BUCKETS - 1);
+}
+
+/**************************************/
+/*   Static varaibles and functions   */
+/**************************************/
+static volatile sig_atomic_t serveStop = 0;
+
+static void
+onSignal(int)
+{
+   serveStop = 1;
+}
+
+static bool
+isPort(const string& addr)
+{
+   if (addr.empty() || addr.size() > 5) return false;
+   for (size_t i = 0; i < addr.size(); ++i)
+      if (!isdigit(addr[i])) return false;
+   return true;
+}
+
+static void
+setNonBlocking(int fd)
+{
+   fcntl(fd, F_SETFL, fcntl(fd, F_GETFL, 0) | O_NONBLOCK);
+}
+
+// Read the next integer of a request into "v" and advance "p" past it;
+// return false if no digit is there
+static bool
+nextLong(const char*& p, long& v)
+{
+   char* end;
+   v = strtol(p, &end, 10);
+   if (end == p) return false;
+   p = end;
+   return true;
+}
+
+// A connection. _in belongs to the epoll thread; the rest is shared with
+// the workers under _mutex. At most one worker serves a connection at a
+// time (_busy), so its responses keep the order of its requests.
+struct MatConn
+{
+   MatConn(int fd)
+      : _fd(fd), _eof(false), _busy(false), _closing(false), _tooLong(false),
+        _writing(false) {}
+   ~MatConn() { close(_fd); }
+
+   int                          _fd;
+   string                       _in;
+   bool                         _eof;      // the peer sends no more
+   mutex                        _mutex;
+   deque<pair<string, double> > _pending;  // request, arrival wall time
+   string                       _out;
+   bool                         _busy;
+   bool                         _closing;  // no more requests are taken
+   bool                         _tooLong;  // a request overflowed _in
+   bool                         _writing;  // waiting for EPOLLOUT
+};
+
+typedef shared_ptr<MatConn> MatConnPtr;
+
+class MatServer
+{
+public:
+   MatServer(CirMgr* mgr, int epfd) : _mgr(mgr), _epfd(epfd), _done(false) {}
+
+   void start(int threads);
+   void stop();
+   void onRead(const MatConnPtr& conn);
+   void onWrite(const MatConnPtr& conn);
+   const MatLatency& getLatency() const { return _latency; }
+
+private:
+   CirMgr*                  _mgr;
+   int                      _epfd;
+   MatLatency               _latency;
+   deque<MatConnPtr>        _queue;     // connections with requests
+   mutex                    _queueMutex;
+   condition_variable       _queueCond;
+   bool                     _done;
+   vector<thread>           _workers;
+
+   void work();
+   bool handle(const string& req, string& resp);
+   void flush(MatConn& conn);
+   void watch(MatConn& conn);
+   void dispatch(const MatConnPtr& conn);
+};
+
+void
+MatServer::start(int threads)
+{
+   for (int i = 0; i < threads; ++i)
+      _workers.push_back(thread(&MatServer::work, this));
+}
+
+void
+MatServer::stop()
+{
+   {
+      lock_guard<mutex> lock(_queueMutex);
+      _done = true;
+   }
+   _queueCond.notify_all();
+   for (size_t i = 0; i < _workers.size(); ++i) _workers[i].join();
+   _workers.clear();
+}
+
+// Split the received bytes into requests. The complete lines that come
+// with the end of input are still served; a last line without '\n' is
+// dropped.
+void
+MatServer::onRead(const MatConnPtr& conn)
+{
+   char buf[4096];
+   bool eof = false;
+   while (true) {
+      ssize_t n = recv(conn->_fd, buf, sizeof(buf), 0);
+      if (n > 0) { conn->_in.append(buf, n); continue; }
+      if (n < 0 && errno == EINTR) continue;
+      if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+      eof = true;
+      break;
+   }
+
+   bool queued = false;
+   size_t begin = 0, nl;
+   double now = myUsage.getWallTime();
+   {
+      lock_guard<mutex> lock(conn->_mutex);
+      if (eof && !conn->_eof) {
+         conn->_eof = true;
+         watch(*conn);   // a half-closed socket stays readable
+      }
+      if (conn->_closing) conn->_in.clear();
+      while ((nl = conn->_in.find('\n', begin)) != string::npos) {
+         size_t end = nl;
+         if (end > begin && conn->_in[end-1] == '\r') --end;
+         conn->_pending.push_back(
+            make_pair(conn->_in.substr(begin, end - begin), now));
+         begin = nl + 1;
+      }
+      conn->_in.erase(0, begin);
+      if (conn->_in.size() > MAT_SERVE_LINE) {
+         conn->_in.clear();
+         conn->_tooLong = conn->_closing = true;
+      }
+      if (eof) conn->_in.clear();
+      if ((!conn->_pending.empty() || conn->_tooLong) && !conn->_busy)
+         conn->_busy = queued = true;
+   }
+   if (queued) dispatch(conn);
+}
+
+void
+MatServer::onWrite(const MatConnPtr& conn)
+{
+   lock_guard<mutex> lock(conn->_mutex);
+   flush(*conn);
+}
+
+void
+MatServer::dispatch(const MatConnPtr& conn)
+{
+   {
+      lock_guard<mutex> lock(_queueMutex);
+      _queue.push_back(conn);
+   }
+   _queueCond.notify_one();
+}
+
+// Send what is buffered; the rest waits for EPOLLOUT. Called with
+// conn._mutex held.
+void
+MatServer::flush(MatConn& conn)
+{
+   while (!conn._out.empty()) {
+      ssize_t n = send(conn._fd, conn._out.data(), conn._out.size(),
+                       MSG_NOSIGNAL);
+      if (n > 0) { conn._out.erase(0, n); continue; }
+      if (n < 0 && errno == EINTR) continue;
+      if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) break;
+      conn._out.clear();
+      conn._closing = true;
+   }
+   if (conn._writing == conn._out.empty()) {
+      conn._writing = !conn._out.empty();
+      watch(conn);
+   }
+   // the epoll thread sees the hang-up and drops the connection
+   if (conn._out.empty() && (conn._closing || conn._eof) && !conn._busy)
+      shutdown(conn._fd, SHUT_RDWR);
+}
+
+// The events of interest: EPOLLIN until the end of input, EPOLLOUT while
+// _out waits. Called with conn._mutex held.
+void
+MatServer::watch(MatConn& conn)
+{
+   epoll_event ev;
+   ev.events = (conn._eof ? 0u : unsigned(EPOLLIN)) |
+               (conn._writing ? unsigned(EPOLLOUT) : 0u);
+   ev.data.fd = conn._fd;
+   epoll_ctl(_epfd, EPOLL_CTL_MOD, conn._fd, &ev);
+}
+
+void
+MatServer::work()
+{
+   while (true) {
+      MatConnPtr conn;
+      {
+         unique_lock<mutex> lock(_queueMutex);
+         while (_queue.empty() && !_done) _queueCond.wait(lock);
+         if (_queue.empty()) return;
+         conn = _queue.front();
+         _queue.pop_front();
+      }
+      string resp;
+      while (true) {
+         pair<string, double> req;
+         {
+            lock_guard<mutex> lock(conn->_mutex);
+            if (conn->_pending.empty()) {
+               // after the requests before it; see onRead()
+               if (conn->_tooLong) {
+                  conn->_out += "ERR request is too long\n";
+                  conn->_tooLong = false;
+               }
+               conn->_busy = false;
+               flush(*conn);
+               break;
+            }
+            req = conn->_pending.front();
+            conn->_pending.pop_front();
+         }
+         resp.clear();
+         bool quit = !handle(req.first, resp);
+         lock_guard<mutex> lock(conn->_mutex);
+         conn->_out += resp;
+         if (quit) { conn->_closing = true; conn->_pending.clear(); }
+         flush(*conn);
+         _latency.add((myUsage.getWallTime() - req.second) * 1e6);
+      }
+   }
+}
+
+// Return false if the connection is to be closed
+bool
+MatServer::handle(const string& req, string& resp)
+{
+   static thread_local ScoreList result;
+   char buf[64];
+   const char* p = req.c_str();
+   if (req.empty()) { resp = "ERR empty request\n"; return true; }
+   switch (p[0]) {
+      case 'P': case 'p': {
+         long user, movie;
+         double score;
+         ++p;
+         if (!nextLong(p, user) || !nextLong(p, movie) || *p != '\0' ||
+             user < 0 || movie < 0)
+            resp = "ERR usage: P <user> <movie>\n";
+         else if (!_mgr->predict(user, movie, score))
+            resp = "ERR out of range\n";
+         else {
+            snprintf(buf, sizeof(buf), "OK %.6g\n", score);
+            resp = buf;
+         }
+         return true;
+      }
+      case 'R': case 'r': {
+         long user, k;
+         ++p;
+         if (!nextLong(p, user) || !nextLong(p, k) || *p != '\0' ||
+             user < 0 || k <= 0 || k > 10000)
+            resp = "ERR usage: R <user> <k>\n";
+         else if (!_mgr->recommend(user, k, result))
+            resp = "ERR out of range\n";
+         else {
+            resp = "OK";
+            for (size_t i = 0; i < result.size(); ++i) {
+               snprintf(buf, sizeof(buf), " %u:%.6g", result[i]._movie,
+                        result[i]._score);
+               resp += buf;
+            }
+            resp += '\n';
+         }
+         return true;
+      }
+      case 'I': case 'i':
+         snprintf(buf, sizeof(buf), "OK %d %d %d\n", _mgr->getMaxUserId(),
+                  _mgr->getMaxMovieId(), _mgr->getLatent());
+         resp = buf;
+         return true;
+      case 'S': case 's': {
+         MatCacheStats stats;
+         _mgr->getCacheStats(stats);
+         snprintf(buf, sizeof(buf), "OK %llu %.1f %.1f %.3f\n",
+                  _latency.count(), _latency.percentile(0.5),
+                  _latency.percentile(0.99), stats.hitRate());
+         resp = buf;
+         return true;
+      }
+      case 'Q': case 'q':
+         return false;
+      default:
+         resp = "ERR unknown request\n";
+         return true;
+   }
+}
+
+// A listening socket on "addr"; see matServe()
+static int
+listenOn(const string& addr)
+{
+   int fd;
+   if (isPort(addr)) {
+      fd = socket(AF_INET, SOCK_STREAM, 0);
+      int one = 1;
+      setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof(one));
+      sockaddr_in sa;
+      memset(&sa, 0, sizeof(sa));
+      sa.sin_family = AF_INET;
+      sa.sin_port = htons(atoi(addr.c_str()));
+      sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      if (fd < 0 || bind(fd, (sockaddr*)&sa, sizeof(sa)) < 0) {
+         if (fd >= 0) close(fd);
+         return -1;
+      }
+   }
+   else {
+      sockaddr_un sa;
+      memset(&sa, 0, sizeof(sa));
+      sa.sun_family = AF_UNIX;
+      if (addr.size() >= sizeof(sa.sun_path)) return -1;
+      strcpy(sa.sun_path, addr.c_str());
+      unlink(addr.c_str());
+      fd = socket(AF_UNIX, SOCK_STREAM, 0);
+      if (fd < 0 || bind(fd, (sockaddr*)&sa, sizeof(sa)) < 0) {
+         if (fd >= 0) close(fd);
+         return -1;
+      }
+   }
+   if (listen(fd, SOMAXCONN) < 0) { close(fd); return -1; }
+   setNonBlocking(fd);
+   return fd;
+}
+
+/**************************************/
+/*   Global functions                 */
+/**************************************/
+bool
+matServe(CirMgr* mgr, const string& addr, int threads)
+{
+   int lfd = listenOn(addr);
+   if (lfd < 0) {
+      cerr << "Error: cannot listen on \"" << addr << "\"!!" << endl;
+      return false;
+   }
+   int epfd = epoll_create1(0);
+   epoll_event ev;
+   ev.events = EPOLLIN;
+   ev.data.fd = lfd;
+   epoll_ctl(epfd, EPOLL_CTL_ADD, lfd, &ev);
+
+   serveStop = 0;
+   signal(SIGINT, onSignal);
+   signal(SIGTERM, onSignal);
+   signal(SIGPIPE, SIG_IGN);
+
+   MatServer server(mgr, epfd);
+   server.start(threads);
+   cout << "Serving on " << addr << " with " << threads << " workers..."
+        << endl;
+   double start = myUsage.getWallTime();
+
+   map<int, MatConnPtr> conns;
+   epoll_event events[MAT_SERVE_EVENTS];
+   while (!serveStop) {
+      int n = epoll_wait(epfd, events, MAT_SERVE_EVENTS, MAT_SERVE_TIMEOUT_MS);
+      for (int i = 0; i < n; ++i) {
+         int fd = events[i].data.fd;
+         if (fd == lfd) {
+            int cfd;
+            while ((cfd = accept(lfd, 0, 0)) >= 0) {
+               int one = 1;
+               setsockopt(cfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+               setNonBlocking(cfd);
+               conns[cfd] = MatConnPtr(new MatConn(cfd));
+               epoll_event cev;
+               cev.events = EPOLLIN;
+               cev.data.fd = cfd;
+               epoll_ctl(epfd, EPOLL_CTL_ADD, cfd, &cev);
+            }
+            continue;
+         }
+         map<int, MatConnPtr>::iterator it = conns.find(fd);
+         if (it == conns.end()) continue;
+         MatConnPtr conn = it->second;
+         if (events[i].events & EPOLLOUT) server.onWrite(conn);
+         if (events[i].events & (EPOLLIN | EPOLLHUP | EPOLLERR)) {
+            server.onRead(conn);
+            bool closed;
+            {
+               lock_guard<mutex> lock(conn->_mutex);
+               closed = !conn->_busy && conn->_eof && conn->_out.empty();
+            }
+            // a worker may still hold the socket, which closes with it
+            if (closed) {
+               epoll_ctl(epfd, EPOLL_CTL_DEL, fd, 0);
+               conns.erase(it);
+            }
+         }
+      }
+   }
+
+   server.stop();
+   conns.clear();
+   close(epfd);
+   close(lfd);
+   if (!isPort(addr)) unlink(addr.c_str());
+   signal(SIGINT, SIG_DFL);
+   signal(SIGTERM, SIG_DFL);
+
+   const MatLatency& lat = server.getLatency();
+   double elapse = myUsage.getWallTime() - start;
+   cout << "Requests: " << lat.count() << ", "
+        << (elapse > 0 ? lat.count() / elapse : 0.0) << " per second"
+        << ", latency p50: " << lat.percentile(0.5) << " us, p99: "
+        << lat.percentile(0.99) << " us" << endl;
+   MatCacheStats stats;
+   mgr->getCacheStats(stats);
+   cout << "Cache hit rate: " << stats.hitRate() * 100 << "%, "
+        << stats._entries << " results in " << stats._bytes / 1048576.0
+        << " MB" << endl;
+   return true;
+}
+
+int
+matConnect(const string& addr)
+{
+   int fd;
+   if (isPort(addr)) {
+      sockaddr_in sa;
+      memset(&sa, 0, sizeof(sa));
+      sa.sin_family = AF_INET;
+      sa.sin_port = htons(atoi(addr.c_str()));
+      sa.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+      fd = socket(AF_INET, SOCK_STREAM, 0);
+      if (fd < 0 || connect(fd, (sockaddr*)&sa, sizeof(sa)) < 0) {
+         if (fd >= 0) close(fd);
+         return -1;
+      }
+      int one = 1;
+      setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof(one));
+   }
+   else {
+      sockaddr_un sa;
+      memset(&sa, 0, sizeof(sa));
+      sa.sun_family = AF_UNIX;
+      if (addr.size() >= sizeof(sa.sun_path)) return -1;
+      strcpy(sa.sun_path, addr.c_str());
+      fd = socket(AF_UNIX, SOCK_STREAM, 0);
+      if (fd < 0 || connect(fd, (sockaddr*)&sa, sizeof(sa)) < 0) {
+         if (fd >= 0) close(fd);
+         return -1;
+      }
+   }
+   return fd;
+}
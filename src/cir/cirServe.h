@@ -0,0 +1,54 @@
+/****************************************************************************
+  FileName     [ cirServe.h ]
+  PackageName  [ cir ]
+  Synopsis     [ Define the recommendation server and its line protocol ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#ifndef CIR_SERVE_H
+#define CIR_SERVE_H
+
+#include <string>
+#include <atomic>
+
+using namespace std;
+
+class CirMgr;
+
+// Requests and responses are single lines:
+//    P <user> <movie>   ->  OK <score>
+//    R <user> <k>       ->  OK <movie>:<score> ...   (best first)
+//    I                  ->  OK <maxUserId> <maxMovieId> <latent>
+//    S                  ->  OK <requests> <p50 us> <p99 us> <cache hit rate>
+//    Q                  ->  (the connection is closed)
+// Anything else is answered by "ERR <reason>".
+
+// Log-linear histogram of latencies in microseconds; 8 sub-buckets per
+// power of 2, so a percentile is off by at most 12.5%
+#define MAT_LAT_BUCKETS  (64 * 8)
+
+class MatLatency
+{
+public:
+   MatLatency() { reset(); }
+
+   void reset();
+   void add(double us);
+   unsigned long long count() const { return _total.load(); }
+   double percentile(double p) const;
+
+private:
+   atomic<unsigned long long> _count[MAT_LAT_BUCKETS];
+   atomic<unsigned long long> _total;
+};
+
+// Serve the published model of "mgr" on "addr", a port number on the
+// loopback interface or the path of a Unix socket, with "threads"
+// workers. Return at SIGINT or SIGTERM, false if "addr" cannot be served.
+bool matServe(CirMgr* mgr, const string& addr, int threads);
+
+// A connected blocking socket to "addr", or -1
+int matConnect(const string& addr);
+
+#endif // CIR_SERVE_H
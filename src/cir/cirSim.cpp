@@ -0,0 +1,325 @@
+/****************************************************************************
+  FileName     [ cirSim.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define cir simulation functions ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <iostream>
+#include <string>
+#include <cstring>
+#include <algorithm>
+#include <unordered_map>
+#include "cirMgr.h"
+#include "rnGen.h"
+#include "util.h"
+
+using namespace std;
+
+#define CIR_SIM_BITS  (CIR_SIM_WORDS * 64)
+
+typedef unsigned long long SimWord;
+
+/**************************************/
+/*   Static varaibles and functions   */
+/**************************************/
+static SimWord
+randomWord()
+{
+    return (SimWord(my_random()) << 62) ^ (SimWord(my_random()) << 31) ^
+           SimWord(my_random());
+}
+
+// The patterns >= "n" of a pass repeat pattern 0, so that a partial pass
+// adds no new behavior
+static void
+padPatterns(SimWord* w, unsigned n)
+{
+    SimWord first = (w[0] & 1) ? ~SimWord(0) : 0;
+    for (unsigned k = 0; k < CIR_SIM_WORDS; ++k) {
+        SimWord pad = n <= k * 64 ? ~SimWord(0)
+                    : n >= (k + 1) * 64 ? 0 : ~SimWord(0) << (n - k * 64);
+        w[k] = (w[k] & ~pad) | (first & pad);
+    }
+}
+
+// Literal of gate lit/2 that is 0 in pattern 0
+static inline unsigned
+normLit(const SimWord* v, unsigned lit)
+{
+    const unsigned id = lit / 2;
+    return 2 * id + (v[size_t(id) * CIR_SIM_WORDS] & 1);
+}
+
+// Hash and equality of the signatures of literals id*2+inv, with "inv"
+// applied to every word
+struct FecHash
+{
+    const SimWord* _v;
+    size_t operator() (unsigned lit) const {
+        const SimWord* w = _v + size_t(lit / 2) * CIR_SIM_WORDS;
+        const SimWord m = -SimWord(lit & 1);
+        SimWord h = 0;
+        for (unsigned k = 0; k < CIR_SIM_WORDS; ++k)
+            h += (w[k] ^ m) * (2 * k + 1);
+        h *= 0x9e3779b97f4a7c15ULL;
+        return size_t(h ^ (h >> 29));
+    }
+};
+
+struct FecEqual
+{
+    const SimWord* _v;
+    bool operator() (unsigned a, unsigned b) const {
+        const SimWord* wa = _v + size_t(a / 2) * CIR_SIM_WORDS;
+        const SimWord* wb = _v + size_t(b / 2) * CIR_SIM_WORDS;
+        const SimWord m = -SimWord((a ^ b) & 1);
+        for (unsigned k = 0; k < CIR_SIM_WORDS; ++k)
+            if (wa[k] != (wb[k] ^ m)) return false;
+        return true;
+    }
+};
+
+typedef unordered_map<unsigned, unsigned, FecHash, FecEqual> FecClasses;
+
+/************************************************/
+/*   Public member functions about Simulation   */
+/************************************************/
+// Simulate "passes" passes of random patterns; returns the patterns
+size_t
+CirMgr::randomSim(unsigned passes)
+{
+    IdList ops;
+    buildSimOps(ops);
+    for (unsigned p = 0; p < passes; ++p) {
+        randomPis();
+        simPass(ops, CIR_SIM_BITS);
+    }
+    return size_t(passes) * CIR_SIM_BITS;
+}
+
+// One pattern of 0/1, as many as the PIs, per whitespace-separated word.
+// A bad pattern stops the simulation; those before it are simulated, and
+// counted in "patterns".
+bool
+CirMgr::fileSim(istream& patternFile, size_t& patterns)
+{
+    IdList ops;
+    buildSimOps(ops);
+    const IdList& pis = _aig.getPiList();
+    unsigned n = 0;
+    bool ok = true;
+    string pattern;
+    patterns = 0;
+    while (patternFile >> pattern) {
+        if (pattern.size() != pis.size()) {
+            cerr << "Error: Pattern(" << pattern << ") length("
+                 << pattern.size() << ") does not match the number of inputs("
+                 << pis.size() << ") in a circuit!!" << endl;
+            ok = false;
+            break;
+        }
+        size_t bad = pattern.find_first_not_of("01");
+        if (bad != string::npos) {
+            cerr << "Error: Pattern(" << pattern
+                 << ") contains a non-0/1 character('" << pattern[bad]
+                 << "')." << endl;
+            ok = false;
+            break;
+        }
+        if (n == 0)
+            for (size_t i = 0; i < pis.size(); ++i)
+                memset(&_simValue[size_t(pis[i]) * CIR_SIM_WORDS], 0,
+                       CIR_SIM_WORDS * sizeof(SimWord));
+        for (size_t i = 0; i < pis.size(); ++i)
+            _simValue[size_t(pis[i]) * CIR_SIM_WORDS + n / 64] |=
+                SimWord(pattern[i] - '0') << (n % 64);
+        if (++n == CIR_SIM_BITS) {
+            simPass(ops, n);
+            patterns += n;
+            n = 0;
+        }
+    }
+    if (n != 0) {
+        simPass(ops, n);
+        patterns += n;
+    }
+    return ok;
+}
+
+// "[i] id !id ..." per group, by the smallest id; "!" marks the members
+// complementary to the first one
+void
+CirMgr::printFECPairs() const
+{
+    vector<IdList> grps(_fecGrps);
+    for (size_t i = 0; i < grps.size(); ++i)
+        sort(grps[i].begin(), grps[i].end());
+    sort(grps.begin(), grps.end());
+    for (size_t i = 0; i < grps.size(); ++i) {
+        const IdList& grp = grps[i];
+        cout << '[' << i << ']';
+        for (size_t j = 0; j < grp.size(); ++j)
+            cout << ' ' << (((grp[j] ^ grp[0]) & 1) ? "!" : "") << grp[j] / 2;
+        cout << endl;
+    }
+}
+
+/*************************************************/
+/*   Private member functions about Simulation   */
+/*************************************************/
+// Triples (out, lit0, lit1) in _netList order: an AIG is the AND of its
+// fanins, and a PO the AND of its fanin and CONST 1. Clears _simValue.
+void
+CirMgr::buildSimOps(IdList& ops)
+{
+    ops.clear();
+    ops.reserve(_netList.size() * 3);
+    for (size_t i = 0; i < _netList.size(); ++i) {
+        unsigned id = _netList[i];
+        GateType type = _aig.getType(id);
+        if (type != AIG_GATE && type != PO_GATE) continue;
+        ops.push_back(id);
+        ops.push_back(_aig.getFanin(id, 0));
+        ops.push_back(type == AIG_GATE ? _aig.getFanin(id, 1) : 1);
+    }
+    // CONST 0 and the UNDEF gates are never written
+    _simValue.assign(size_t(_aig.size()) * CIR_SIM_WORDS, 0);
+    if (!_fecInit) {
+        _fecGrps.assign(1, IdList(1, 0));
+        for (size_t i = 0; i < ops.size(); i += 3)
+            if (_aig.getType(ops[i]) == AIG_GATE)
+                _fecGrps[0].push_back(2 * ops[i]);
+        // members stay in this order; by id, the signatures are read in
+        // the order of _simValue
+        sort(_fecGrps[0].begin(), _fecGrps[0].end());
+        _fecInit = true;
+    }
+}
+
+// Random patterns into the PI words of _simValue
+void
+CirMgr::randomPis()
+{
+    const IdList& pis = _aig.getPiList();
+    for (size_t i = 0; i < pis.size(); ++i) {
+        SimWord* w = &_simValue[size_t(pis[i]) * CIR_SIM_WORDS];
+        for (unsigned k = 0; k < CIR_SIM_WORDS; ++k) w[k] = randomWord();
+    }
+}
+
+// A pass of the first "patterns" patterns in the PI words of _simValue
+void
+CirMgr::simPass(const IdList& ops, unsigned patterns)
+{
+    if (patterns < CIR_SIM_BITS) {
+        const IdList& pis = _aig.getPiList();
+        for (size_t i = 0; i < pis.size(); ++i)
+            padPatterns(&_simValue[size_t(pis[i]) * CIR_SIM_WORDS], patterns);
+    }
+    simulate(ops);
+    refineFec();
+    logSim(patterns);
+}
+
+// Evaluate the ops on the PI words of _simValue. The inner loop is
+// branch-free and of a fixed length, so that it vectorizes.
+void
+CirMgr::simulate(const IdList& ops)
+{
+    SimWord* v = &_simValue[0];
+    for (size_t i = 0, n = ops.size(); i < n; i += 3) {
+        SimWord* out = v + size_t(ops[i]) * CIR_SIM_WORDS;
+        const SimWord* a = v + size_t(ops[i+1] / 2) * CIR_SIM_WORDS;
+        const SimWord* b = v + size_t(ops[i+2] / 2) * CIR_SIM_WORDS;
+        const SimWord ma = -SimWord(ops[i+1] & 1);
+        const SimWord mb = -SimWord(ops[i+2] & 1);
+        // "out" may be a fanin for the compiler; compute in full first
+        SimWord t[CIR_SIM_WORDS];
+        for (unsigned k = 0; k < CIR_SIM_WORDS; ++k)
+            t[k] = (a[k] ^ ma) & (b[k] ^ mb);
+        for (unsigned k = 0; k < CIR_SIM_WORDS; ++k)
+            out[k] = t[k];
+    }
+}
+
+// Split every FEC group by the signatures of the last pass. A member is
+// normalized by normLit(), so that complementary gates share a class of
+// the hash table; the work is linear in the members. Members
+// like the first one, usually all, skip the table.
+void
+CirMgr::refineFec()
+{
+    const SimWord* v = &_simValue[0];
+    FecHash hash = { v };
+    FecEqual equal = { v };
+    vector<IdList> grps;
+    grps.reserve(_fecGrps.size());
+    for (size_t g = 0; g < _fecGrps.size(); ++g) {
+        IdList& grp = _fecGrps[g];
+        grp[0] = normLit(v, grp[0]);
+        size_t i = 1;
+        for (; i < grp.size(); ++i) {
+            grp[i] = normLit(v, grp[i]);
+            if (!equal(grp[0], grp[i])) break;
+        }
+        if (i == grp.size()) {
+            if (grp.size() < 2) continue;   // the seed of a circuit with no AIGs
+            grps.push_back(IdList());
+            grps.back().swap(grp);
+            continue;
+        }
+        const size_t first = grps.size();
+        grps.push_back(IdList(grp.begin(), grp.begin() + i));
+        FecClasses classes(8, hash, equal);
+        for (; i < grp.size(); ++i) {
+            grp[i] = normLit(v, grp[i]);
+            if (equal(grp[0], grp[i])) {
+                grps[first].push_back(grp[i]);
+                continue;
+            }
+            FecClasses::iterator c = classes.find(grp[i]);
+            if (c == classes.end()) {
+                c = classes.insert(c, make_pair(grp[i], unsigned(grps.size())));
+                grps.push_back(IdList());
+            }
+            grps[c->second].push_back(grp[i]);
+        }
+        size_t n = first;
+        for (size_t j = first; j < grps.size(); ++j)
+            if (grps[j].size() > 1) grps[n++].swap(grps[j]);
+        grps.resize(n);
+    }
+    _fecGrps.swap(grps);
+}
+
+// Forget the values and the FEC groups, when the netlist changes
+void
+CirMgr::resetSim()
+{
+    _simValue.clear();
+    _fecGrps.clear();
+    _fecInit = false;
+}
+
+// Log the first "patterns" patterns of the last pass
+void
+CirMgr::logSim(unsigned patterns) const
+{
+    if (_simLog == 0) return;
+    const IdList& pis = _aig.getPiList();
+    const IdList& pos = _aig.getPoList();
+    string line(pis.size() + pos.size() + 2, ' ');
+    line[line.size() - 1] = '\n';
+    for (unsigned p = 0; p < patterns; ++p) {
+        const size_t word = p / 64, bit = p % 64;
+        for (size_t i = 0; i < pis.size(); ++i)
+            line[i] = '0' + ((_simValue[size_t(pis[i]) * CIR_SIM_WORDS + word]
+                              >> bit) & 1);
+        for (size_t i = 0; i < pos.size(); ++i)
+            line[pis.size() + 1 + i] = '0' +
+                ((_simValue[size_t(pos[i]) * CIR_SIM_WORDS + word] >> bit) & 1);
+        _simLog->write(line.data(), line.size());
+    }
+}
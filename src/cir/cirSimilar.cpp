@@ -0,0 +1,185 @@
+/****************************************************************************
+  FileName     [ cirSimilar.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define the item-item similarity table ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <iostream>
+#include <algorithm>
+#include <cmath>
+#include <thread>
+#include "cirMgr.h"
+#include "cirKernel.h"
+#include "util.h"
+
+using namespace std;
+
+// Tile of the similarity matrix computed at a time: MAT_SIM_ROWS movies
+// against MAT_SIM_COLS movies, whose latent-major slice stays in L2
+#define MAT_SIM_ROWS  16
+#define MAT_SIM_COLS  128
+
+/**************************************/
+/*   Static varaibles and functions   */
+/**************************************/
+// Order for a min-heap on score: the worst of the current top N at front
+struct SimGreater
+{
+    bool operator() (const MovieScore& a, const MovieScore& b) const {
+        return a._score != b._score ? a._score > b._score : a._movie < b._movie;
+    }
+};
+
+// Work shared by the threads of buildSimilar()
+struct SimJob
+{
+    const IdList*        _movies;   // rows and columns, ascending ids
+    const float*         _rows;     // [movie][latent]
+    const float*         _cols;     // [latent][movie], padded to MAT_SIM_COLS
+    size_t               _stride;   // of _cols
+    int                  _latent;
+    unsigned             _n;        // neighbors per movie
+    atomic<size_t>       _next;     // first row of the next block
+    vector<ScoreList>*   _best;     // per row, best first when done
+};
+
+// Claim blocks of MAT_SIM_ROWS rows until none is left. A tile is computed
+// as a sum of rank-1 updates, so that the inner loop runs along a row of
+// _cols and vectorizes without reordering a sum.
+static void
+simWorker(SimJob* job)
+{
+    const size_t n = job->_movies->size();
+    const int latent = job->_latent;
+    vector<float> tile(MAT_SIM_ROWS * MAT_SIM_COLS);
+    SimGreater cmp;
+    size_t r0;
+    while ((r0 = job->_next.fetch_add(MAT_SIM_ROWS)) < n) {
+        size_t rows = min(size_t(MAT_SIM_ROWS), n - r0);
+        for (size_t c0 = 0; c0 < n; c0 += MAT_SIM_COLS) {
+            size_t cols = min(size_t(MAT_SIM_COLS), n - c0);
+            fill(tile.begin(), tile.end(), 0.0f);
+            for (size_t i = 0; i < rows; ++i) {
+                const float* a = job->_rows + (r0 + i) * latent;
+                float* t = &tile[i * MAT_SIM_COLS];
+                for (int k = 0; k < latent; ++k)
+                    matAxpyFloat(a[k], job->_cols + k * job->_stride + c0,
+                                 t, MAT_SIM_COLS);
+            }
+            for (size_t i = 0; i < rows; ++i) {
+                ScoreList& best = (*job->_best)[r0 + i];
+                const float* t = &tile[i * MAT_SIM_COLS];
+                for (size_t j = 0; j < cols; ++j) {
+                    if (c0 + j == r0 + i) continue;
+                    MovieScore ms = { (*job->_movies)[c0 + j], t[j] };
+                    if (best.size() < job->_n) {
+                        best.push_back(ms);
+                        push_heap(best.begin(), best.end(), cmp);
+                    }
+                    else if (cmp(ms, best.front())) {
+                        pop_heap(best.begin(), best.end(), cmp);
+                        best.back() = ms;
+                        push_heap(best.begin(), best.end(), cmp);
+                    }
+                }
+            }
+        }
+        for (size_t i = 0; i < rows; ++i) {
+            ScoreList& best = (*job->_best)[r0 + i];
+            sort_heap(best.begin(), best.end(), cmp);
+        }
+    }
+}
+
+/*******************************************************/
+/*   class CirMgr member functions for similarity      */
+/*******************************************************/
+// Find the "n" nearest rated movies of every rated movie in the published
+// model, by cosine or inner product, on "threads" threads. It may run
+// while the model is being trained; lookups see the old table until the
+// new one is complete.
+bool
+CirMgr::buildSimilar(unsigned n, bool cosine, int threads)
+{
+    MyUsagePhase phase(myUsage, "similar");
+    IdList rated;
+    vector<float> rows, cols;
+    int latent, maxMovieId;
+    size_t m, stride;
+    {
+        // the rows are copied, so the model may be reclaimed during the build
+        MatModelReader reader(_model);
+        const MatModel* model = reader.get();
+        if (model == 0) return false;
+        const IdList& movies = model->getIndex()._movieIdList;
+        latent = model->getLatent();
+        maxMovieId = model->getMaxMovieId();
+        for (size_t i = 0; i < movies.size(); ++i)
+            if (movies[i] <= unsigned(maxMovieId)) rated.push_back(movies[i]);
+        m = rated.size();
+        stride = (m + MAT_SIM_COLS - 1) / MAT_SIM_COLS * MAT_SIM_COLS;
+        rows.resize(m * latent);
+        cols.assign(stride * latent, 0.0f);
+        for (size_t i = 0; i < m; ++i) {
+            const double* v = model->getMovie(rated[i]);
+            double norm = cosine ? sqrt(matDot(v, v, latent)) : 1.0;
+            if (norm == 0.0) norm = 1.0;
+            for (int k = 0; k < latent; ++k) {
+                rows[i * latent + k] = float(v[k] / norm);
+                cols[k * stride + i] = float(v[k] / norm);
+            }
+        }
+    }
+
+    vector<ScoreList> best(m);
+    SimJob job;
+    job._movies = &rated;
+    job._rows = rows.empty() ? 0 : &rows[0];
+    job._cols = cols.empty() ? 0 : &cols[0];
+    job._stride = stride;
+    job._latent = latent;
+    job._n = n;
+    job._next = 0;
+    job._best = &best;
+    if (threads < 1) threads = 1;
+    vector<thread> workers;
+    for (int t = 1; t < threads; ++t)
+        workers.push_back(thread(simWorker, &job));
+    simWorker(&job);
+    for (size_t t = 0; t < workers.size(); ++t) workers[t].join();
+
+    MatSimTable* table = new MatSimTable;
+    table->_cosine = cosine;
+    table->_start.assign(maxMovieId + 2, 0);
+    for (size_t i = 0; i < m; ++i)
+        table->_start[rated[i] + 1] = best[i].size();
+    for (size_t j = 1; j < table->_start.size(); ++j)
+        table->_start[j] += table->_start[j-1];
+    table->_movies.reserve(table->_start.back());
+    table->_scores.reserve(table->_start.back());
+    for (size_t i = 0; i < m; ++i)
+        for (size_t j = 0; j < best[i].size(); ++j) {
+            table->_movies.push_back(best[i][j]._movie);
+            table->_scores.push_back(float(best[i][j]._score));
+        }
+    atomic_store(&_simTable, shared_ptr<const MatSimTable>(table));
+    return true;
+}
+
+// Up to "k" neighbors of "movie" from the last buildSimilar(), best first
+bool
+CirMgr::similar(unsigned movie, unsigned k, ScoreList& result) const
+{
+    shared_ptr<const MatSimTable> table = atomic_load(&_simTable);
+    result.clear();
+    if (!table || size_t(movie) + 1 >= table->_start.size()) return false;
+    size_t begin = table->_start[movie], end = table->_start[movie+1];
+    if (end - begin > k) end = begin + k;
+    for (size_t i = begin; i < end; ++i) {
+        MovieScore ms = { table->_movies[i], table->_scores[i] };
+        result.push_back(ms);
+    }
+    return true;
+}
@@ -0,0 +1,188 @@
+/****************************************************************************
+  FileName     [ cirStream.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define online SGD updates from a rating feed ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <iostream>
+#include <cmath>
+#include <unistd.h>
+#include "cirMgr.h"
+#include "cirKernel.h"
+#include "cirCkpt.h"
+#include "cirInput.h"
+#include "util.h"
+
+using namespace std;
+
+// Microseconds to wait for a followed feed to grow
+#define MAT_STREAM_POLL_US  50000
+
+/*************************************************/
+/*   class CirMgr member functions for streaming */
+/*************************************************/
+// Apply the rating events of "file" ("-" for stdin) to the trained factors
+// and return when the feed ends
+bool
+CirMgr::stream(const string& file)
+{
+    MatInput* in = new MatInput(file);
+    if (!in->isOpen()) {
+        cerr << "Error: cannot open feed \"" << file << "\"!!" << endl;
+        delete in;
+        return false;
+    }
+    runStream(in, false);
+    return true;
+}
+
+// As stream(), on the worker thread of trainBackground(); MATSTOp ends it
+bool
+CirMgr::streamBackground(const string& file)
+{
+    if (isTraining()) return false;
+    MatInput* in = new MatInput(file);
+    if (!in->isOpen()) {
+        cerr << "Error: cannot open feed \"" << file << "\"!!" << endl;
+        delete in;
+        return false;
+    }
+    joinTraining();
+    _stopRequest = false;
+    {
+        lock_guard<mutex> lock(_statusMutex);
+        _status._running = true;
+    }
+    _trainThread = new thread(&CirMgr::runStream, this, in, true);
+    return true;
+}
+
+// Events are applied one by one in arrival order, but read, checked for
+// new ids and counted a micro-batch at a time. In-process readers get a
+// new model at most every MAT_PUBLISH_SEC (see cirRec.cpp). Every
+// _publishEvery events the rating index is rebuilt and the factors are
+// also published as a checkpoint (see cirCkpt.h), which is renamed into
+// place so that other processes only ever see whole snapshots. "in" is
+// deleted here.
+void
+CirMgr::runStream(MatInput* in, bool background)
+{
+    MyUsagePhase phase(myUsage, "stream");
+    {
+        lock_guard<mutex> lock(_statusMutex);
+        _status._running = _status._stream = true;
+        _status._stopped = false;
+        _status._background = background;
+        _status._events = 0;
+        _status._rmse = 0.0;
+        _status._start = myUsage.getWallTime();
+        _status._elapse = 0.0;
+    }
+    MatCkptWriter* writer = 0;
+    MatCkpt ckpt;
+    if (!_publishFile.empty()) writer = new MatCkptWriter(_publishFile);
+
+    RatingList batch;
+    IdList times;
+    batch.reserve(_streamBatch);
+    times.reserve(_streamBatch);
+    long long events = 0, published = 0, lineNo = 0;
+    double sse = 0.0;
+    bool eof = false;
+    while (!eof && !_stopRequest) {
+        batch.clear();
+        times.clear();
+        while (int(batch.size()) < _streamBatch) {
+            char* line = in->getLine(!_follow);
+            if (line == 0) {
+                if (in->full()) {
+                    cerr << "Error: line is too long in the feed!!" << endl;
+                    eof = true;
+                }
+                else if (!_follow) eof = true;
+                else if (batch.empty() && !_stopRequest) {
+                    usleep(MAT_STREAM_POLL_US);
+                    continue;
+                }
+                break;
+            }
+            long userId, movieId;
+            double rating;
+            unsigned long stamp;
+            ++lineNo;
+            if (!matParseRating(line, userId, movieId, rating, stamp) ||
+                rating <= 0)
+                continue;
+            if (userId > MAT_MAX_ID || movieId > MAT_MAX_ID) {
+                cerr << "Error: id is larger than " << MAT_MAX_ID << " on line "
+                     << lineNo << " of the feed!!" << endl;
+                continue;
+            }
+            Rating r = { unsigned(userId), unsigned(movieId), float(rating) };
+            batch.push_back(r);
+            times.push_back(stamp);
+        }
+        if (batch.empty()) continue;
+
+        sse += applyBatch(batch, times);
+        events += batch.size();
+        if (writer && events - published >= _publishEvery) {
+            countRatings();
+            saveCheckpoint(0, ckpt);
+            writer->submit(ckpt);
+            published = events;
+        }
+        maybePublish(true);
+        lock_guard<mutex> lock(_statusMutex);
+        _status._events = events;
+        _status._rmse = sqrt(sse / events);
+        _status._elapse = myUsage.getWallTime() - _status._start;
+    }
+    delete in;
+
+    countRatings();
+    if (writer && published != events) {
+        saveCheckpoint(0, ckpt);
+        writer->submit(ckpt);
+    }
+    delete writer;
+    publishModel(true);
+
+    lock_guard<mutex> lock(_statusMutex);
+    _status._elapse = myUsage.getWallTime() - _status._start;
+    _status._stopped = _stopRequest;
+    _status._running = false;
+    if (background) return;
+    cout << "Events: " << events << ", prequential RMSE: " << _status._rmse
+         << ", time: " << _status._elapse << " seconds" << endl;
+}
+
+// One SGD step per event; the factors grow first if the batch brings new
+// ids. Return the squared error of the events before their updates.
+double
+CirMgr::applyBatch(const RatingList& batch, const IdList& times)
+{
+    int maxUserId = _maxUserId, maxMovieId = _maxMovieId;
+    for (size_t r = 0, n = batch.size(); r < n; ++r) {
+        if (int(batch[r]._user) > maxUserId) maxUserId = batch[r]._user;
+        if (int(batch[r]._movie) > maxMovieId) maxMovieId = batch[r]._movie;
+    }
+    if (maxUserId > _maxUserId || maxMovieId > _maxMovieId)
+        growFactors(maxUserId, maxMovieId);
+
+    double sse = 0.0;
+    for (size_t r = 0, n = batch.size(); r < n; ++r) {
+        const Rating& rt = batch[r];
+        double* u = _userMatrix[rt._user];
+        double* m = _movieMatrix[rt._movie];
+        double eij = rt._rating - matDot(u, m, _latent);
+        sse += eij * eij;
+        matSgdStep(u, m, eij, _learningRate, _lambda, _latent);
+        _touchedUsers.push_back(rt._user);
+    }
+    _ratingList.insert(_ratingList.end(), batch.begin(), batch.end());
+    _timeList.insert(_timeList.end(), times.begin(), times.end());
+    return sse;
+}
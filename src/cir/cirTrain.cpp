@@ -0,0 +1,677 @@
+/****************************************************************************
+  FileName     [ cirTrain.cpp ]
+  PackageName  [ cir ]
+  Synopsis     [ Define matrix factorization training and epoch ordering ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2008-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+
+#include <iostream>
+#include <iomanip>
+#include <fstream>
+#include <algorithm>
+#include <cstdlib>
+#include <cmath>
+#include <cstring>
+#include "cirMgr.h"
+#include "cirKernel.h"
+#include "cirCkpt.h"
+#include "util.h"
+
+using namespace std;
+
+// Bytes of factor rows one tile should touch; sized for a private L2
+#define MAT_TILE_BYTES  (256 << 10)
+
+/**************************************/
+/*   Static varaibles and functions   */
+/**************************************/
+static const char* orderStr[ORDER_TOT] =
+    { "User", "Shuffle", "Block", "Hilbert" };
+static const char* splitStr[SPLIT_TOT] = { "Random", "Time" };
+
+// Rows share one contiguous block so that mat[0] owns the storage
+static double**
+newMatrix(int rows, int cols)
+{
+    double** mat = new double*[rows];
+    mat[0] = new double[size_t(rows) * cols];
+    for (int i = 1; i < rows; ++i)
+        mat[i] = mat[0] + size_t(i) * cols;
+    return mat;
+}
+
+static void
+deleteMatrix(double** mat)
+{
+    if (mat == 0) return;
+    delete [] mat[0];
+    delete [] mat;
+}
+
+// Fisher-Yates on [begin, end)
+template<class T>
+static void
+shuffleRange(T* begin, T* end, const RandomEngine& rng)
+{
+    for (size_t i = end - begin; i > 1; --i) {
+        size_t j = rng(i);
+        if (j >= i) j = i - 1;
+        swap(begin[i-1], begin[j]);
+    }
+}
+
+// Distance of (x, y) along the Hilbert curve filling an n x n grid
+// (n must be a power of 2)
+static unsigned long long
+hilbertIndex(unsigned n, unsigned x, unsigned y)
+{
+    unsigned long long d = 0;
+    for (unsigned s = n / 2; s > 0; s /= 2) {
+        unsigned rx = (x & s) ? 1 : 0;
+        unsigned ry = (y & s) ? 1 : 0;
+        d += (unsigned long long)s * s * ((3 * rx) ^ ry);
+        if (ry == 0) {
+            if (rx == 1) { x = n-1 - x; y = n-1 - y; }
+            swap(x, y);
+        }
+    }
+    return d;
+}
+
+struct RatingLess
+{
+    bool operator() (const Rating& a, const Rating& b) const {
+        return a._user != b._user ? a._user < b._user : a._movie < b._movie;
+    }
+};
+
+struct TileLess
+{
+    TileLess(unsigned side) : _side(side) {}
+    bool operator() (const Rating& a, const Rating& b) const {
+        unsigned ua = a._user / _side, ub = b._user / _side;
+        if (ua != ub) return ua < ub;
+        unsigned ma = a._movie / _side, mb = b._movie / _side;
+        if (ma != mb) return ma < mb;
+        return RatingLess()(a, b);
+    }
+    unsigned _side;
+};
+
+struct TimeLess
+{
+    TimeLess(const IdList& time) : _time(time) {}
+    bool operator() (size_t a, size_t b) const { return _time[a] < _time[b]; }
+    const IdList& _time;
+};
+
+/****************************************************/
+/*   class CirMgr member functions for MF training  */
+/****************************************************/
+void
+CirMgr::printSettings() const
+{
+    cout << endl;
+    cout << "Training Settings" << endl
+         << "==================" << endl
+         << "     LATENT " << setw(11) << right << _latent << endl
+         << " ITERATIONS " << setw(11) << right << _iterations << endl
+         << "   LEARNING " << setw(11) << right << _learningRate << endl
+         << "     LAMBDA " << setw(11) << right << _lambda << endl
+         << "      ORDER " << setw(11) << right << orderStr[_order] << endl
+         << "     TARGET " << setw(11) << right << _target << endl
+         << " VALIDATION " << setw(11) << right << _validRatio << endl
+         << "      SPLIT " << setw(11) << right << splitStr[_split] << endl;
+    if (!_logFile.empty())
+        cout << "        LOG " << setw(11) << right << _logFile << endl;
+    if (!_ckptFile.empty())
+        cout << " CHECKPOINT " << setw(11) << right << _ckptFile
+             << " (every " << _ckptEvery << ")" << endl;
+    if (_quantize)
+        cout << "   QUANTIZE " << setw(11) << right << "int8" << endl;
+}
+
+// Lay out _trainList once per training run. ORDER_USER and ORDER_HILBERT
+// are fixed orders; ORDER_SHUFFLE and ORDER_BLOCK are re-permuted per epoch
+// by orderRatings().
+void
+CirMgr::buildTrainList()
+{
+    _trainList.clear();
+    _validList.clear();
+    if (_validRatio > 0 && _split == SPLIT_TIME) {
+        // the latest ratings are held out; equal timestamps keep file order
+        size_t n = _ratingList.size(), nValid = size_t(_validRatio * n + 0.5);
+        vector<size_t> byTime(n);
+        for (size_t r = 0; r < n; ++r) byTime[r] = r;
+        stable_sort(byTime.begin(), byTime.end(), TimeLess(_timeList));
+        vector<bool> held(n, false);
+        for (size_t i = n - nValid; i < n; ++i) held[byTime[i]] = true;
+        for (size_t r = 0; r < n; ++r) {
+            if (held[r]) _validList.push_back(_ratingList[r]);
+            else _trainList.push_back(_ratingList[r]);
+        }
+    }
+    else if (_validRatio > 0) {
+        RandomEngine rng(_seed);
+        for (size_t r = 0, n = _ratingList.size(); r < n; ++r) {
+            if (rng.uniform() < _validRatio) _validList.push_back(_ratingList[r]);
+            else _trainList.push_back(_ratingList[r]);
+        }
+    }
+    else _trainList = _ratingList;
+    _tileList.clear();
+    switch (_order) {
+        case ORDER_BLOCK: {
+            unsigned side = MAT_TILE_BYTES / (2 * _latent * sizeof(double));
+            if (side == 0) side = 1;
+            sort(_trainList.begin(), _trainList.end(), TileLess(side));
+            for (size_t i = 0, n = _trainList.size(); i < n; ++i) {
+                if (i == 0 || _trainList[i]._user / side != _trainList[i-1]._user / side
+                    || _trainList[i]._movie / side != _trainList[i-1]._movie / side)
+                    _tileList.push_back(i);
+            }
+            _tileList.push_back(_trainList.size());
+            break;
+        }
+        case ORDER_HILBERT: {
+            unsigned n = 1, maxId = max(_maxUserId, _maxMovieId);
+            while (n <= maxId) n <<= 1;
+            vector<pair<unsigned long long, unsigned> > keys(_trainList.size());
+            for (size_t i = 0; i < keys.size(); ++i)
+                keys[i] = make_pair(hilbertIndex(n, _trainList[i]._user,
+                                    _trainList[i]._movie), unsigned(i));
+            sort(keys.begin(), keys.end());
+            RatingList tmp(_trainList.size());
+            for (size_t i = 0; i < keys.size(); ++i)
+                tmp[i] = _trainList[keys[i].second];
+            _trainList.swap(tmp);
+            break;
+        }
+        default:
+            sort(_trainList.begin(), _trainList.end(), RatingLess());
+            break;
+    }
+}
+
+// The permutation of an epoch depends only on (_seed, epoch) and the order
+// left by the previous epoch, so the order of any epoch can be replayed from
+// buildTrainList() without the history of the random number generator.
+void
+CirMgr::orderRatings(int epoch)
+{
+    if (_trainList.empty()) return;
+    if (_order == ORDER_SHUFFLE) {
+        RandomEngine rng(_seed + epoch);
+        shuffleRange(&_trainList[0], &_trainList[0] + _trainList.size(), rng);
+    }
+    else if (_order == ORDER_BLOCK) {
+        RandomEngine rng(_seed + epoch);
+        size_t nTiles = _tileList.size() - 1;
+        vector<size_t> tiles(nTiles);
+        for (size_t t = 0; t < nTiles; ++t) tiles[t] = t;
+        shuffleRange(&tiles[0], &tiles[0] + nTiles, rng);
+
+        RatingList tmp;
+        tmp.reserve(_trainList.size());
+        vector<size_t> bounds;
+        bounds.reserve(_tileList.size());
+        for (size_t t = 0; t < nTiles; ++t) {
+            size_t b = _tileList[tiles[t]], e = _tileList[tiles[t]+1];
+            shuffleRange(&_trainList[0] + b, &_trainList[0] + e, rng);
+            bounds.push_back(tmp.size());
+            tmp.insert(tmp.end(), _trainList.begin() + b, _trainList.begin() + e);
+        }
+        bounds.push_back(tmp.size());
+        _trainList.swap(tmp);
+        _tileList.swap(bounds);
+    }
+}
+
+// Return the regularized squared error of the training ratings;
+// "rmse" gets the plain RMSE
+double
+CirMgr::trainError(double& rmse) const
+{
+    MyUsagePhase phase(myUsage, "eval");
+    double e = 0, sse = 0;
+    for (size_t r = 0, n = _trainList.size(); r < n; ++r) {
+        const Rating& rt = _trainList[r];
+        const double* u = _userMatrix[rt._user];
+        const double* m = _movieMatrix[rt._movie];
+        double eij = rt._rating - matDot(u, m, _latent);
+        sse += eij * eij;
+        if (_lambda != 0.0)
+            e += _lambda * (matDot(u, u, _latent) + matDot(m, m, _latent));
+    }
+    rmse = _trainList.empty() ? 0.0 : sqrt(sse / _trainList.size());
+    return e + sse;
+}
+
+// RMSE of the held-out ratings
+double
+CirMgr::validError() const
+{
+    MyUsagePhase phase(myUsage, "eval");
+    double sse = 0;
+    for (size_t r = 0, n = _validList.size(); r < n; ++r) {
+        const Rating& rt = _validList[r];
+        double eij = rt._rating -
+                     matDot(_userMatrix[rt._user], _movieMatrix[rt._movie], _latent);
+        sse += eij * eij;
+    }
+    return _validList.empty() ? 0.0 : sqrt(sse / _validList.size());
+}
+
+void
+CirMgr::clearFactors()
+{
+    deleteMatrix(_userMatrix);  _userMatrix = 0;
+    deleteMatrix(_movieMatrix); _movieMatrix = 0;
+}
+
+// Draw the initial factors and lay out the ratings for the first epoch
+void
+CirMgr::initTraining()
+{
+    MyUsagePhase phase(myUsage, "build");
+    clearFactors();
+    double** userMatrix = newMatrix(_maxUserId+1, _latent);
+    for (int i = 0; i < _maxUserId+1; ++i) {
+        for (int j = 0; j < _latent; ++j) {
+            userMatrix[i][j] = (rand() % 2000 - 1000) * 0.0001;
+        }
+    }
+    // Movie factors are stored row-per-movie, but drawn in the latent-major
+    // order so that the initial model does not depend on the layout
+    double** movieMatrix = newMatrix(_maxMovieId+1, _latent);
+    for (int i = 0; i < _latent; ++i) {
+        for (int j = 0; j < _maxMovieId+1; ++j) {
+            movieMatrix[j][i] = (rand() % 2000 - 1000) * 0.0001;
+        }
+    }
+    _userMatrix = userMatrix;
+    _movieMatrix = movieMatrix;
+
+    buildTrainList();
+}
+
+// Load "file" for the next train(). The checkpoint must come from the same
+// ratings; its settings replace the current ones, since the rating order
+// and the factors depend on them.
+bool
+CirMgr::setResume(const string& file)
+{
+    MatCkpt* ckpt = new MatCkpt;
+    if (!ckpt->read(file)) { delete ckpt; return false; }
+    const MatCkptHeader& h = ckpt->_header;
+    if (h._maxUserId != _maxUserId || h._maxMovieId != _maxMovieId ||
+        h._ratings != _ratings || h._order < 0 || h._order >= ORDER_TOT ||
+        h._split < 0 || h._split >= SPLIT_TOT) {
+        cerr << "Error: checkpoint \"" << file
+             << "\" does not match the ratings!!" << endl;
+        delete ckpt;
+        return false;
+    }
+    _order = MatOrderType(h._order);
+    _seed = h._seed;
+    _latent = h._latent;
+    _learningRate = h._learningRate;
+    _lambda = h._lambda;
+    _validRatio = h._validRatio;
+    _split = MatSplitType(h._split);
+    delete _resume;
+    _resume = ckpt;
+    return true;
+}
+
+// Restore the factors of _resume and replay the rating order up to its
+// epoch; return the first epoch to train
+int
+CirMgr::resumeTraining()
+{
+    MyUsagePhase phase(myUsage, "build");
+    clearFactors();
+    double** userMatrix = newMatrix(_maxUserId+1, _latent);
+    double** movieMatrix = newMatrix(_maxMovieId+1, _latent);
+    copy(_resume->_user.begin(), _resume->_user.end(), userMatrix[0]);
+    copy(_resume->_movie.begin(), _resume->_movie.end(), movieMatrix[0]);
+    _userMatrix = userMatrix;
+    _movieMatrix = movieMatrix;
+
+    buildTrainList();
+    int epoch = _resume->_header._epoch;
+    for (int e = 1; e <= epoch; ++e) orderRatings(e);
+    delete _resume;
+    _resume = 0;
+    return epoch + 1;
+}
+
+// Take the factors of checkpoint "file" as the model of the ratings and
+// publish it. The checkpoint may cover more ids than the ratings, e.g. one
+// written by MATSTReam -Publish.
+bool
+CirMgr::loadModel(const string& file)
+{
+    MatCkpt ckpt;
+    if (!ckpt.read(file)) return false;
+    const MatCkptHeader& h = ckpt._header;
+    if (h._maxUserId < _maxUserId || h._maxMovieId < _maxMovieId) {
+        cerr << "Error: checkpoint \"" << file
+             << "\" does not match the ratings!!" << endl;
+        return false;
+    }
+    clearFactors();
+    _latent = h._latent;
+    _maxUserId = h._maxUserId;
+    _maxMovieId = h._maxMovieId;
+    double** userMatrix = newMatrix(_maxUserId+1, _latent);
+    double** movieMatrix = newMatrix(_maxMovieId+1, _latent);
+    copy(ckpt._user.begin(), ckpt._user.end(), userMatrix[0]);
+    copy(ckpt._movie.begin(), ckpt._movie.end(), movieMatrix[0]);
+    _userMatrix = userMatrix;
+    _movieMatrix = movieMatrix;
+    buildRatingIndex();
+    publishModel();
+    return true;
+}
+
+void
+CirMgr::saveCheckpoint(int epoch, MatCkpt& ckpt) const
+{
+    MyUsagePhase phase(myUsage, "ckpt");
+    MatCkptHeader& h = ckpt._header;
+    memset(&h, 0, sizeof(h));
+    memcpy(h._magic, MAT_CKPT_MAGIC, 4);
+    h._version = MAT_CKPT_VERSION;
+    h._epoch = epoch;
+    h._seed = _seed;
+    h._order = _order;
+    h._latent = _latent;
+    h._maxUserId = _maxUserId;
+    h._maxMovieId = _maxMovieId;
+    h._ratings = _ratings;
+    h._learningRate = _learningRate;
+    h._lambda = _lambda;
+    h._validRatio = _validRatio;
+    h._split = _split;
+    ckpt._user.assign(_userMatrix[0],
+                      _userMatrix[0] + size_t(_maxUserId+1) * _latent);
+    ckpt._movie.assign(_movieMatrix[0],
+                       _movieMatrix[0] + size_t(_maxMovieId+1) * _latent);
+}
+
+// Extend the factors to "maxUserId" and "maxMovieId"; the new rows are
+// drawn as in initTraining()
+void
+CirMgr::growFactors(int maxUserId, int maxMovieId)
+{
+    double** userMatrix = newMatrix(maxUserId+1, _latent);
+    copy(_userMatrix[0], _userMatrix[0] + size_t(_maxUserId+1) * _latent,
+         userMatrix[0]);
+    for (int i = _maxUserId+1; i < maxUserId+1; ++i)
+        for (int j = 0; j < _latent; ++j)
+            userMatrix[i][j] = (rand() % 2000 - 1000) * 0.0001;
+    double** movieMatrix = newMatrix(maxMovieId+1, _latent);
+    copy(_movieMatrix[0], _movieMatrix[0] + size_t(_maxMovieId+1) * _latent,
+         movieMatrix[0]);
+    for (int i = _maxMovieId+1; i < maxMovieId+1; ++i)
+        for (int j = 0; j < _latent; ++j)
+            movieMatrix[i][j] = (rand() % 2000 - 1000) * 0.0001;
+
+    clearFactors();
+    _userMatrix = userMatrix;
+    _movieMatrix = movieMatrix;
+    lock_guard<mutex> lock(_statusMutex);   // see printSummary()
+    _maxUserId = maxUserId;
+    _maxMovieId = maxMovieId;
+}
+
+// One SGD pass over all ratings; "epoch" starts from 1
+void
+CirMgr::trainEpoch(int epoch)
+{
+    MyUsagePhase phase(myUsage, "sgd");
+    orderRatings(epoch);
+    for (size_t r = 0, n = _trainList.size(); r < n; ++r) {
+        const Rating& rt = _trainList[r];
+        double* u = _userMatrix[rt._user];
+        double* m = _movieMatrix[rt._movie];
+        double eij = rt._rating - matDot(u, m, _latent);
+        matSgdStep(u, m, eij, _learningRate, _lambda, _latent);
+    }
+}
+
+// Each epoch is reported as a one-line progress record on cout and, with
+// -Log, as one JSON object per line. Wall and CPU time cover the SGD pass
+// only; the loss evaluation that follows is not included. A background run
+// keeps cout quiet (see printStatus) and checks for a stop request at every
+// epoch boundary.
+void
+CirMgr::train(bool background)
+{
+    MyUsagePhase phase(myUsage, "train");
+    {
+        lock_guard<mutex> lock(_statusMutex);
+        _status._running = true;
+        _status._stopped = false;
+        _status._background = background;
+        _status._stream = false;
+        _status._firstEpoch = _resume ? _resume->_header._epoch + 1 : 1;
+        _status._epoch = _status._bestEpoch = 0;
+        _status._loss = _status._rmse = _status._validRmse = 0.0;
+        _status._start = myUsage.getWallTime();
+        _status._elapse = 0.0;
+    }
+    int iters = _resume ? resumeTraining() : (initTraining(), 1);
+    ofstream logFile;
+    if (!_logFile.empty()) {
+        logFile.open(_logFile.c_str());
+        if (!logFile)
+            cerr << "Error: cannot open log file \"" << _logFile << "\"!!"
+                 << endl;
+    }
+
+    // dot (2L) + two updates (5L each) per rating
+    double flops = 12.0 * _latent * _trainList.size();
+    double start = myUsage.getWallTime(), rmse = 0.0, validRmse = 0.0;
+    int first = iters, saved = iters - 1;
+    MatCkptWriter* writer = 0;
+    MatCkpt ckpt;
+    if (!_ckptFile.empty()) writer = new MatCkptWriter(_ckptFile);
+    for (; iters < _iterations; ++iters) {
+        double wall = myUsage.getWallTime(), cpu = myUsage.getCpuTime();
+        trainEpoch(iters);
+        wall = myUsage.getWallTime() - wall;
+        cpu = myUsage.getCpuTime() - cpu;
+        double e = trainError(rmse);
+        if (!_validList.empty()) validRmse = validError();
+        double rate = wall > 0 ? _trainList.size() / wall : 0.0;
+        double gflops = wall > 0 ? flops / wall * 1e-9 : 0.0;
+        double rss = myUsage.getRssMem();
+        updateStatus(iters, e, rmse, validRmse);
+        maybePublish();
+
+        if (!background) {
+            cout << "epoch " << iters << "/" << _iterations - 1
+                 << "  loss " << e << "  rmse " << rmse;
+            if (!_validList.empty()) cout << "  valid " << validRmse;
+            cout << "  " << setprecision(3) << wall << "s  " << rate * 1e-6
+                 << "M r/s  " << gflops << " GFLOP/s  RSS " << rss << "M"
+                 << setprecision(6) << endl;
+        }
+        if (logFile.is_open()) {
+            logFile << "{\"epoch\": " << iters << ", \"wall_s\": " << wall
+                    << ", \"cpu_s\": " << cpu << ", \"ratings_per_s\": " << rate
+                    << ", \"gflops\": " << gflops << ", \"train_loss\": " << e
+                    << ", \"train_rmse\": " << rmse << ", \"valid_rmse\": ";
+            if (_validList.empty()) logFile << "null";
+            else logFile << validRmse;
+            logFile << ", \"rss_mb\": " << rss << "}" << endl;
+        }
+        if (writer && iters % _ckptEvery == 0) {
+            saveCheckpoint(iters, ckpt);
+            writer->submit(ckpt);
+            saved = iters;
+        }
+        if (_target > 0 && rmse <= _target) { ++iters; break; }
+        if (_stopRequest) { ++iters; break; }
+    }
+    // the last epoch is always saved; the writer drains before it is gone
+    if (writer && saved != iters - 1) {
+        saveCheckpoint(iters - 1, ckpt);
+        writer->submit(ckpt);
+    }
+    delete writer;
+
+    {
+        lock_guard<mutex> lock(_statusMutex);
+        if (_stopRequest && _status._bestEpoch != _status._epoch &&
+            !_bestUser.empty()) {
+            copy(_bestUser.begin(), _bestUser.end(), _userMatrix[0]);
+            copy(_bestMovie.begin(), _bestMovie.end(), _movieMatrix[0]);
+        }
+        _bestUser.clear(); _bestMovie.clear();
+    }
+    publishModel();
+
+    lock_guard<mutex> lock(_statusMutex);
+    _status._stopped = _stopRequest;
+    _status._running = false;
+    if (background) return;
+
+    int epochs = iters - first;
+    double elapse = myUsage.getWallTime() - start;
+    cout << "Order: " << orderStr[_order] << ", epochs: " << epochs
+         << ", RMSE: " << rmse;
+    if (!_validList.empty()) cout << ", validation RMSE: " << validRmse;
+    cout << ", time: " << elapse << " seconds ("
+         << (epochs ? elapse / epochs : 0.0) << " per epoch)" << endl;
+    if (_target > 0 && rmse > _target)
+        cout << "Warning: target RMSE " << _target << " is not reached!!"
+             << endl;
+}
+
+// Publish the progress of "epoch". The best epoch is judged on the
+// validation RMSE when there is a validation set; a background run keeps
+// a copy of its factors so that MATSTOp can roll back to them.
+void
+CirMgr::updateStatus(int epoch, double loss, double rmse, double validRmse)
+{
+    double score = _validList.empty() ? rmse : validRmse;
+    bool keep = false;
+    {
+        lock_guard<mutex> lock(_statusMutex);
+        _status._epoch = epoch;
+        _status._loss = loss;
+        _status._rmse = rmse;
+        _status._validRmse = validRmse;
+        _status._elapse = myUsage.getWallTime() - _status._start;
+        if (_status._bestEpoch == 0 || score < _status._bestRmse) {
+            _status._bestEpoch = epoch;
+            _status._bestRmse = score;
+            keep = _status._background;
+        }
+    }
+    if (!keep) return;
+    // copy outside the lock so that MATSTatus does not wait on the factors
+    size_t nu = size_t(_maxUserId+1) * _latent;
+    size_t nm = size_t(_maxMovieId+1) * _latent;
+    vector<double> user(_userMatrix[0], _userMatrix[0] + nu);
+    vector<double> movie(_movieMatrix[0], _movieMatrix[0] + nm);
+    lock_guard<mutex> lock(_statusMutex);
+    _bestUser.swap(user);
+    _bestMovie.swap(movie);
+}
+
+/*******************************************************/
+/*   class CirMgr member functions for background run  */
+/*******************************************************/
+bool
+CirMgr::isTraining() const
+{
+    lock_guard<mutex> lock(_statusMutex);
+    return _status._running;
+}
+
+// Start train() on a worker thread; return false if one is still running
+bool
+CirMgr::trainBackground()
+{
+    if (isTraining()) return false;
+    joinTraining();
+    _stopRequest = false;
+    {
+        // set before the thread starts so that isTraining() holds at once
+        lock_guard<mutex> lock(_statusMutex);
+        _status._running = true;
+    }
+    _trainThread = new thread(&CirMgr::train, this, true);
+    return true;
+}
+
+// Ask the worker to stop at the end of its current epoch and wait for it.
+// Return false if no training is running.
+bool
+CirMgr::stopTraining()
+{
+    bool running = isTraining();
+    if (running) _stopRequest = true;
+    joinTraining();
+    _stopRequest = false;
+    return running;
+}
+
+void
+CirMgr::joinTraining()
+{
+    if (_trainThread == 0) return;
+    _trainThread->join();
+    delete _trainThread;
+    _trainThread = 0;
+}
+
+void
+CirMgr::printStatus() const
+{
+    lock_guard<mutex> lock(_statusMutex);
+    const TrainStatus& s = _status;
+    if (s._stream) {
+        double elapse = s._running ? myUsage.getWallTime() - s._start
+                                   : s._elapse;
+        cout << "Stream " << (s._running ? "is running" :
+                              s._stopped ? "is stopped" : "is finished")
+             << endl << "  events " << s._events << "  prequential rmse "
+             << s._rmse << endl << "  elapsed " << setprecision(3) << elapse
+             << "s  " << (elapse > 0 ? s._events / elapse : 0.0)
+             << " events/s" << setprecision(6) << endl;
+        return;
+    }
+    if (s._epoch == 0) {
+        cout << (s._running ? "Training is initializing." :
+                              "No training is started.") << endl;
+        return;
+    }
+    int total = _iterations - 1;
+    double elapse = s._running ? myUsage.getWallTime() - s._start : s._elapse;
+    int done = s._epoch - s._firstEpoch + 1;
+    double perEpoch = done > 0 ? s._elapse / done : 0.0;
+    cout << "Training " << (s._running ? "is running" :
+                            s._stopped ? "is stopped" : "is finished")
+         << " (" << orderStr[_order] << ")" << endl
+         << "  epoch " << s._epoch << "/" << total << "  loss " << s._loss
+         << "  rmse " << s._rmse;
+    // _validList belongs to the worker; _validRatio is only set by commands
+    if (_validRatio > 0) cout << "  valid " << s._validRmse;
+    cout << endl << "  elapsed " << setprecision(3) << elapse << "s  "
+         << perEpoch << "s per epoch";
+    if (s._running)
+        cout << "  ETA " << perEpoch * (total - s._epoch) << "s";
+    cout << setprecision(6) << endl;
+    if (s._epoch)
+        cout << (s._stopped ? "  kept factors of epoch " : "  best epoch ")
+             << s._bestEpoch << "  "
+             << (_validRatio > 0 ? "valid " : "rmse ") << s._bestRmse
+             << endl;
+}
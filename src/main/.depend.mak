@@ -1 +1,5 @@
-main.o: main.cpp ../../include/cmdParser.h ../../include/cmdCharDef.h
+main.o: main.cpp ../../include/util.h ../../include/rnGen.h \
+ ../../include/myUsage.h ../../include/cmdParser.h \
+ ../../include/cmdCharDef.h ../../include/cirMgr.h ../../include/cirDef.h \
+ ../../include/cirModel.h ../../include/cirCache.h ../../include/cirAig.h \
+ ../../include/cirServe.h
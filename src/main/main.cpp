@@ -9,6 +9,8 @@
 #include <cstdlib>
 #include "util.h"
 #include "cmdParser.h"
+#include "cirMgr.h"
+#include "cirServe.h"
 
 using namespace std;
 
@@ -23,7 +25,11 @@ extern bool initCirCmd();
 static void
 usage()
 {
-   cout << "Usage: cirTest [ -File < doFile > ]" << endl;
+   cout << "Usage: cirTest [ -File < doFile > ]" << endl
+        << "       cirTest -Serve < port | socket > -Ratings < file >"
+        << " -Model < checkpoint >" << endl
+        << "              [ -Threads < n > ] [ -Cache < MB > ] [ -Quantize ]"
+        << endl;
 }
 
 static void
@@ -33,6 +39,56 @@ myexit()
    exit(-1);
 }
 
+// Serve the model of a checkpoint trained on the ratings; see cirServe.h
+static int
+serve(int argc, char** argv)
+{
+   string addr, ratings, model;
+   int threads = 4, cache = MAT_CACHE_MB;
+   bool quantize = false;
+   for (int i = 1; i < argc; ++i) {
+      if (myStrNCmp("-Quantize", argv[i], 2) == 0) {
+         quantize = true;
+         continue;
+      }
+      if (i + 1 == argc) {
+         cerr << "Error: missing value for \"" << argv[i] << "\"!!\n";
+         myexit();
+      }
+      if (myStrNCmp("-Serve", argv[i], 2) == 0) addr = argv[++i];
+      else if (myStrNCmp("-Ratings", argv[i], 2) == 0) ratings = argv[++i];
+      else if (myStrNCmp("-Model", argv[i], 2) == 0) model = argv[++i];
+      else if (myStrNCmp("-Threads", argv[i], 2) == 0) {
+         if (!myStr2Int(argv[++i], threads) || threads <= 0 ||
+             threads > MAT_RCU_POOL) {
+            cerr << "Error: illegal number of threads \"" << argv[i]
+                 << "\"!!\n";
+            myexit();
+         }
+      }
+      else if (myStrNCmp("-Cache", argv[i], 2) == 0) {
+         if (!myStr2Int(argv[++i], cache) || cache < 0) {
+            cerr << "Error: illegal cache size \"" << argv[i] << "\"!!\n";
+            myexit();
+         }
+      }
+      else {
+         cerr << "Error: unknown argument \"" << argv[i] << "\"!!\n";
+         myexit();
+      }
+   }
+   if (addr.empty() || ratings.empty() || model.empty()) myexit();
+
+   cirMgr = new CirMgr;
+   cirMgr->setCacheSize(size_t(cache) << 20);
+   cirMgr->setQuantize(quantize);
+   bool ok = cirMgr->readMatrix(ratings) && cirMgr->loadModel(model) &&
+             matServe(cirMgr, addr, threads);
+   delete cirMgr;
+   cirMgr = 0;
+   return ok ? 0 : 1;
+}
+
 int
 main(int argc, char** argv)
 {
@@ -40,6 +96,8 @@ main(int argc, char** argv)
 
    ifstream dof;
 
+   if (argc > 1 && myStrNCmp("-Serve", argv[1], 2) == 0)
+      return serve(argc, argv);
    if (argc == 3) {  // -file <doFile>
       if (myStrNCmp("-File", argv[1], 2) == 0) {
          if (!cmdMgr->openDofile(argv[2])) {
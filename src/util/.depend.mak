@@ -1,3 +1,4 @@
-myString.o: myString.cpp
 myGetChar.o: myGetChar.cpp
+myString.o: myString.cpp
+myUsage.o: myUsage.cpp myUsage.h
 util.o: util.cpp rnGen.h myUsage.h
@@ -9,6 +9,7 @@
 #include <ctype.h>
 #include <cstring>
 #include <cassert>
+#include <cstdlib>
 
 using namespace std;
 
@@ -78,6 +79,18 @@ myStr2Int(const string& str, int& num)
    return valid;
 }
 
+// Convert string "str" to double "num". Return false if str does not appear
+// to be a number
+bool
+myStr2Double(const string& str, double& num)
+{
+   num = 0.0;
+   if (str.empty()) return false;
+   char* end = 0;
+   num = strtod(str.c_str(), &end);
+   return (*end == '\0');
+}
+
 // Valid var name is ---
 // 1. starts with [a-zA-Z_]
 // 2. others, can only be [a-zA-Z0-9_]
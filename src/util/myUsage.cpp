@@ -0,0 +1,173 @@
+/****************************************************************************
+  FileName     [ myUsage.cpp ]
+  PackageName  [ util ]
+  Synopsis     [ Phase timers and hardware counters of MyUsage ]
+  Author       [ Chung-Yang (Ric) Huang ]
+  Copyright    [ Copyleft(c) 2007-present LaDs(III), GIEE, NTU, Taiwan ]
+****************************************************************************/
+#include <iostream>
+#include <iomanip>
+#include <vector>
+#include <mutex>
+#include <cstring>
+#include "myUsage.h"
+#ifdef __linux__
+#include <sys/syscall.h>
+#include <sys/ioctl.h>
+#include <linux/perf_event.h>
+#endif
+
+using namespace std;
+
+//----------------------------------------------------------------------
+//    Static variables
+//----------------------------------------------------------------------
+// An open phase; every thread keeps its own stack of them
+struct MyOpenPhase
+{
+   string     _path;
+   double     _wall;
+   double     _cpu;
+   long long  _count[PERF_TOT];
+};
+
+static thread_local vector<MyOpenPhase> phaseStack;
+static mutex phaseMutex;   // guards MyUsage::_phaseMap
+
+//----------------------------------------------------------------------
+//    class MyUsage phase functions
+//----------------------------------------------------------------------
+void
+MyUsage::startPhase(const string& name)
+{
+   MyOpenPhase p;
+   p._path = phaseStack.empty() ? name : phaseStack.back()._path + "/" + name;
+   readPerf(p._count);
+   p._cpu = getCpuTime();
+   p._wall = getWallTime();
+   phaseStack.push_back(p);
+}
+
+void
+MyUsage::stopPhase()
+{
+   if (phaseStack.empty()) return;
+   double wall = getWallTime(), cpu = getCpuTime();
+   long long count[PERF_TOT];
+   readPerf(count);
+
+   const MyOpenPhase& p = phaseStack.back();
+   {
+      lock_guard<mutex> lock(phaseMutex);
+      map<string, PhaseStat>::iterator it = _phaseMap.find(p._path);
+      if (it == _phaseMap.end()) {
+         PhaseStat s;
+         memset(&s, 0, sizeof(s));
+         it = _phaseMap.insert(make_pair(p._path, s)).first;
+      }
+      PhaseStat& s = it->second;
+      ++s._calls;
+      s._wall += wall - p._wall;
+      s._cpu += cpu - p._cpu;
+      for (int i = 0; i < PERF_TOT; ++i)
+         s._count[i] += count[i] - p._count[i];
+   }
+   phaseStack.pop_back();
+}
+
+void
+MyUsage::resetPhases()
+{
+   lock_guard<mutex> lock(phaseMutex);
+   _phaseMap.clear();
+}
+
+// One line per phase path, children indented under their parent with the
+// share of the parent's wall time
+void
+MyUsage::reportPhases() const
+{
+   lock_guard<mutex> lock(phaseMutex);
+   if (_phaseMap.empty()) { cout << "No phase is recorded." << endl; return; }
+
+   bool perf = isPerfEnabled();
+   cout << setw(24) << left << "Phase" << setw(8) << right << "Calls"
+        << setw(12) << "Wall(s)" << setw(12) << "CPU(s)" << setw(8) << "%";
+   if (perf)
+      cout << setw(14) << "Cycles" << setw(14) << "Instrs" << setw(6) << "IPC"
+           << setw(12) << "LLC-miss";
+   cout << endl;
+
+   map<string, PhaseStat>::const_iterator it = _phaseMap.begin();
+   for (; it != _phaseMap.end(); ++it) {
+      const string& path = it->first;
+      const PhaseStat& s = it->second;
+      size_t slash = path.rfind('/'), depth = 0;
+      for (size_t i = 0; i < path.size(); ++i) if (path[i] == '/') ++depth;
+      string name = string(2 * depth, ' ') +
+                    (slash == string::npos ? path : path.substr(slash + 1));
+      double share = 100.0;
+      if (slash != string::npos) {
+         map<string, PhaseStat>::const_iterator pi =
+            _phaseMap.find(path.substr(0, slash));
+         if (pi != _phaseMap.end() && pi->second._wall > 0)
+            share = 100.0 * s._wall / pi->second._wall;
+      }
+      cout << setw(24) << left << name << setw(8) << right << s._calls
+           << fixed << setprecision(4) << setw(12) << s._wall << setw(12)
+           << s._cpu << setprecision(1) << setw(8) << share;
+      if (perf) {
+         double ipc = s._count[PERF_CYCLES] ?
+            double(s._count[PERF_INSTRS]) / s._count[PERF_CYCLES] : 0.0;
+         cout << setw(14) << s._count[PERF_CYCLES] << setw(14)
+              << s._count[PERF_INSTRS] << setprecision(2) << setw(6) << ipc
+              << setw(12) << s._count[PERF_LLC_MISSES];
+      }
+      cout.unsetf(ios::fixed);
+      cout << setprecision(6) << endl;
+   }
+}
+
+//----------------------------------------------------------------------
+//    Hardware counters
+//----------------------------------------------------------------------
+// Counters follow the whole process, including threads created later.
+// Return false if the kernel refuses them (e.g. perf_event_paranoid).
+bool
+MyUsage::enablePerf(bool on)
+{
+   for (int i = 0; i < PERF_TOT; ++i)
+      if (_perfFd[i] >= 0) { close(_perfFd[i]); _perfFd[i] = -1; }
+   if (!on) return true;
+#ifdef __linux__
+   static const unsigned long long config[PERF_TOT] = {
+      PERF_COUNT_HW_CPU_CYCLES, PERF_COUNT_HW_INSTRUCTIONS,
+      PERF_COUNT_HW_CACHE_MISSES };
+   for (int i = 0; i < PERF_TOT; ++i) {
+      perf_event_attr attr;
+      memset(&attr, 0, sizeof(attr));
+      attr.size = sizeof(attr);
+      attr.type = PERF_TYPE_HARDWARE;
+      attr.config = config[i];
+      attr.inherit = 1;
+      attr.exclude_kernel = 1;
+      attr.exclude_hv = 1;
+      _perfFd[i] = syscall(__NR_perf_event_open, &attr, 0, -1, -1, 0);
+      if (_perfFd[i] < 0) { enablePerf(false); return false; }
+   }
+   return true;
+#else
+   return false;
+#endif
+}
+
+void
+MyUsage::readPerf(long long* count) const
+{
+   for (int i = 0; i < PERF_TOT; ++i) {
+      count[i] = 0;
+      if (_perfFd[i] >= 0 && read(_perfFd[i], &count[i], sizeof(long long))
+                             != sizeof(long long))
+         count[i] = 0;
+   }
+}
@@ -12,6 +12,10 @@
 #include <unistd.h>
 #include <iostream>
 #include <iomanip>
+#include <fstream>
+#include <string>
+#include <map>
+#include <time.h>
 #include <sys/times.h>
 #include <sys/resource.h>
 
@@ -21,11 +25,21 @@ using namespace std;
 #undef MYCLK_TCK
 #define MYCLK_TCK sysconf(_SC_CLK_TCK)
 
+// Hardware counters sampled per phase (Linux perf_event only)
+enum MyPerfCounter
+{
+   PERF_CYCLES     = 0,
+   PERF_INSTRS     = 1,
+   PERF_LLC_MISSES = 2,
+
+   PERF_TOT
+};
+
 
 class MyUsage
 {
 public:
-   MyUsage() { reset(); }
+   MyUsage() { for (int i = 0; i < PERF_TOT; ++i) _perfFd[i] = -1; reset(); }
 
    void reset() {
       _initMem = checkMem();
@@ -48,6 +62,39 @@ public:
       }
    }
 
+   // CPU time (user + system) of the process so far, in seconds
+   double getCpuTime() const {
+      struct rusage usage;
+      if (0 != getrusage(RUSAGE_SELF, &usage)) return 0;
+      return usage.ru_utime.tv_sec + usage.ru_stime.tv_sec +
+             (usage.ru_utime.tv_usec + usage.ru_stime.tv_usec) * 1e-6;
+   }
+   // Current (not peak) resident set size in MB; the peak where unknown
+   double getRssMem() const {
+#ifdef __linux__
+      ifstream statm("/proc/self/statm");
+      long pages, resident;
+      if (statm >> pages >> resident)
+         return resident * double(sysconf(_SC_PAGESIZE)) / double(1<<20);
+#endif
+      return checkMem();
+   }
+   // Monotonic wall clock, in seconds
+   double getWallTime() const {
+      timespec ts;
+      clock_gettime(CLOCK_MONOTONIC, &ts);
+      return ts.tv_sec + ts.tv_nsec * 1e-9;
+   }
+
+   // Named phases (in myUsage.cpp). Phases opened while another one is open
+   // on the same thread are aggregated under it as "parent/child".
+   void startPhase(const string& name);
+   void stopPhase();
+   void resetPhases();
+   void reportPhases() const;
+   bool enablePerf(bool on);
+   bool isPerfEnabled() const { return _perfFd[PERF_CYCLES] >= 0; }
+
 private:
    // for Memory usage (in MB)
    double     _initMem;
@@ -75,6 +122,20 @@ private:
       times(&tBuffer);
       return tBuffer.tms_utime;
    }
+   // The members below are appended after the original ones on purpose:
+   // the prebuilt cmd library (USAGE) accesses those by their offsets.
+   struct PhaseStat
+   {
+      unsigned   _calls;
+      double     _wall;
+      double     _cpu;
+      long long  _count[PERF_TOT];
+   };
+   map<string, PhaseStat>  _phaseMap;    // keyed by the "parent/child" path
+   int                     _perfFd[PERF_TOT];
+
+   void readPerf(long long* count) const;
+
    void setMemUsage() { _currentMem = checkMem() - _initMem; }
    void setTimeUsage() {
       double thisTick = checkTick();
@@ -85,4 +146,17 @@ private:
       
 };
 
+// Times the enclosing scope as phase "name" of "usage"
+class MyUsagePhase
+{
+public:
+   MyUsagePhase(MyUsage& usage, const string& name) : _usage(usage) {
+      _usage.startPhase(name);
+   }
+   ~MyUsagePhase() { _usage.stopPhase(); }
+
+private:
+   MyUsage&  _usage;
+};
+
 #endif // MY_USAGE_H
@@ -12,6 +12,7 @@
 #include <sys/types.h>
 #include <stdlib.h>  
 #include <limits.h>
+#include <random>
 
 #define my_srandom  srandom
 #define my_random   random
@@ -24,6 +25,29 @@ class RandomNumGen
       const int operator() (const int range) const {
          return int(range * (double(my_random()) / INT_MAX));
       }
+      // uniform in [0, 1)
+      const double uniform() const {
+         return double(my_random()) / (double(INT_MAX) + 1.0);
+      }
+};
+
+// Unlike RandomNumGen, which re-seeds the process-wide random(), each
+// RandomEngine has a state of its own, so that threads drawing from
+// different engines never disturb each other's sequence
+class RandomEngine
+{
+   public:
+      RandomEngine(unsigned seed) : _engine(seed) {}
+      const int operator() (const int range) const {
+         return int(range * uniform());
+      }
+      // uniform in [0, 1), of 53 random bits
+      const double uniform() const {
+         return double(_engine() >> 11) / 9007199254740992.0;
+      }
+
+   private:
+      mutable std::mt19937_64 _engine;
 };
 
 #endif // RN_GEN_H